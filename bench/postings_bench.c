@@ -0,0 +1,100 @@
+/***********************************************************************
+ *  File name   : postings_bench.c
+ *  Description : Microbenchmark for the posting list kernels of the
+ *                Inverted Search Project. Compares every intersection
+ *                and union kernel against the scalar merge on random
+ *                sorted lists of balanced and skewed sizes.
+ *
+ *                Build : gcc -O2 -I. bench/postings_bench.c postings.c -o postings_bench
+ *                Run   : ./postings_bench
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "postings.h"
+#include "sorted_lists.h"
+
+#define BENCH_RUNS 200
+
+typedef int (*Kernel)(const unsigned int *, int, const unsigned int *, int, unsigned int *);
+
+typedef struct BenchCase
+{
+    const char *name;
+    Kernel kernel;
+    int minLevel;              // SIMD level required by the kernel
+} BenchCase;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Times BENCH_RUNS calls of a kernel and prints ids processed per second.
+ */
+static void run_case(BenchCase *bc, const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    if (postings_simd_level() < bc->minLevel)
+    {
+        printf("  %-22s (not supported on this CPU)\n", bc->name);
+        return;
+    }
+    int result = 0;
+    double start = now_seconds();
+    for (int r = 0; r < BENCH_RUNS; r++)
+        result = bc->kernel(a, na, b, nb, out);
+    double elapsed = now_seconds() - start;
+    printf("  %-22s %10.1f M ids/s   (%d results)\n", bc->name,
+           (double)(na + nb) * BENCH_RUNS / elapsed / 1e6, result);
+}
+
+int main(void)
+{
+    BenchCase intersect[] = {
+        {"intersect scalar", postings_intersect_scalar, POSTINGS_SIMD_NONE},
+        {"intersect galloping", postings_intersect_galloping, POSTINGS_SIMD_NONE},
+        {"intersect sse4.1", postings_intersect_sse41, POSTINGS_SIMD_SSE41},
+        {"intersect avx2", postings_intersect_avx2, POSTINGS_SIMD_AVX2},
+        {"intersect dispatch", postings_intersect, POSTINGS_SIMD_NONE},
+    };
+    BenchCase unite[] = {
+        {"union scalar", postings_union_scalar, POSTINGS_SIMD_NONE},
+        {"union sse4.1", postings_union_sse41, POSTINGS_SIMD_SSE41},
+        {"union dispatch", postings_union, POSTINGS_SIMD_NONE},
+    };
+    int sizes[][2] = {{100000, 100000}, {100000, 10000}, {100000, 1000}, {100000, 100}};
+    unsigned int range = 1000000;
+
+    unsigned int *a = malloc(range * sizeof(unsigned int));
+    unsigned int *b = malloc(range * sizeof(unsigned int));
+    unsigned int *out = malloc(2 * range * sizeof(unsigned int));
+    if (a == NULL || b == NULL || out == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not allocate benchmark lists\n");
+        return 1;
+    }
+
+    srand(42);
+    printf("SIMD level: %d\n", postings_simd_level());
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int na = generate_list(a, sizes[s][0], range);
+        int nb = generate_list(b, sizes[s][1], range);
+        printf("\n|A| = %d, |B| = %d\n", na, nb);
+        for (size_t k = 0; k < sizeof(intersect) / sizeof(intersect[0]); k++)
+            run_case(&intersect[k], a, na, b, nb, out);
+        for (size_t k = 0; k < sizeof(unite) / sizeof(unite[0]); k++)
+            run_case(&unite[k], a, na, b, nb, out);
+    }
+
+    free(a);
+    free(b);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/***********************************************************************
+ *  File name   : shard_bench.c
+ *  Description : Benchmark for the sharded mode of the Inverted Search
+ *                Project. For 1, 2, 4, ... up to maxShards workers,
+ *                times the build of the shard indexes and a batch of
+ *                two-word AND/OR queries drawn from the first file.
+ *
+ *                Build : gcc -O2 -I. bench/shard_bench.c $(ls *.c | grep -v main.c) -o shard_bench -lpthread
+ *                Run   : ./shard_bench maxShards queries file.txt ...
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "shard.h"
+
+#define BENCH_WORDS 256            // Query words taken from the first file
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Reads up to BENCH_WORDS words of filename. Returns the count.
+ */
+static int read_words(char *filename, char words[][MAX_WORD_LENGTH])
+{
+    FILE *fp = fopen(filename, "r");
+    int count = 0;
+    if (fp == NULL)
+        return 0;
+    while (count < BENCH_WORDS && fscanf(fp, "%19s", words[count]) == 1)
+        count++;
+    fclose(fp);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "Usage: %s maxShards queries file.txt ...\n", argv[0]);
+        return 1;
+    }
+    int maxShards = atoi(argv[1]), queries = atoi(argv[2]);
+    FileList *filelist = NULL;
+    for (int i = 3; i < argc; i++)
+        fileList_insert_last(&filelist, argv[i]);
+
+    static char words[BENCH_WORDS][MAX_WORD_LENGTH];
+    int wordCount = read_words(argv[3], words);
+    if (wordCount < 2 || maxShards < 1 || maxShards > MAX_SHARDS)
+    {
+        fprintf(stderr, "Need 1 to %d shards and at least 2 words in %s\n", MAX_SHARDS, argv[3]);
+        return 1;
+    }
+
+    // Search results go to stdout; only the timings are of interest
+    fflush(stdout);
+    if (freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+    fprintf(stderr, "%8s %12s %14s %12s\n", "shards", "build (s)", "queries (s)", "queries/s");
+    for (int shards = 1; shards <= maxShards; shards *= 2)
+    {
+        ShardCluster cluster = { .count = 0 };
+        double start = now_seconds();
+        if (shardCluster_start(&cluster, filelist, shards) == FAILURE)
+            return 1;
+        double built = now_seconds();
+        for (int q = 0; q < queries; q++)
+        {
+            char query[2][MAX_WORD_LENGTH];
+            strcpy(query[0], words[q % wordCount]);
+            strcpy(query[1], words[(q * 7 + 1) % wordCount]);
+            shardCluster_search(&cluster, query, 2, q & 1);
+        }
+        double done = now_seconds();
+        shardCluster_stop(&cluster);
+        fprintf(stderr, "%8d %12.3f %14.3f %12.0f\n", shards, built - start, done - built,
+                queries / (done - built));
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+/***********************************************************************
+ *  File name   : sorted_lists.h
+ *  Description : Random posting lists shared by the posting list
+ *                benchmark and tests of the Inverted Search Project.
+ *
+ *                Functions:
+ *                - generate_list()
+ *
+ ***********************************************************************/
+
+#ifndef SORTED_LISTS_H
+#define SORTED_LISTS_H
+
+#include <stdlib.h>
+
+/**
+ * Fills list with up to count sorted unique ids drawn from [0, range).
+ * Returns the number of ids written.
+ */
+static inline int generate_list(unsigned int *list, int count, unsigned int range)
+{
+    int n = 0;
+    for (unsigned int id = 0; id < range && n < count; id++)
+    {
+        // Keep each id with probability count / range
+        if ((unsigned int)rand() % range < (unsigned int)count)
+            list[n++] = id;
+    }
+    return n;
+}
+
+#endif
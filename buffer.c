@@ -0,0 +1,87 @@
+/***********************************************************************
+ *  File name   : buffer.c
+ *  Description : Implementation file for the growable text buffer of
+ *                the Inverted Search Project.
+ *
+ *                Functions:
+ *                - buffer_init()
+ *                - buffer_append()
+ *                - buffer_append_str()
+ *                - buffer_append_int()
+ *                - buffer_free()
+ *
+ ***********************************************************************/
+
+#include "buffer.h"
+#include "list.h"
+
+/**
+ * Initializes an empty buffer.
+ */
+void buffer_init(TextBuffer *buffer)
+{
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->failed = 0;
+}
+
+/**
+ * Appends bytes, doubling the allocation when it is full.
+ */
+void buffer_append(TextBuffer *buffer, const char *text, size_t length)
+{
+    if (buffer->failed)
+        return;
+    if (buffer->length + length > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->length + length)
+            capacity *= 2;
+        char *data = realloc(buffer->data, capacity);
+        if (data == NULL)
+        {
+            buffer->failed = 1;
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+}
+
+/**
+ * Appends a NUL-terminated string.
+ */
+void buffer_append_str(TextBuffer *buffer, const char *text)
+{
+    buffer_append(buffer, text, strlen(text));
+}
+
+/**
+ * Appends a decimal integer without going through printf.
+ */
+void buffer_append_int(TextBuffer *buffer, long value)
+{
+    char digits[24];
+    int pos = sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do
+    {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+        digits[--pos] = '-';
+    buffer_append(buffer, digits + pos, sizeof(digits) - pos);
+}
+
+/**
+ * Releases the buffer memory.
+ */
+void buffer_free(TextBuffer *buffer)
+{
+    free(buffer->data);
+    buffer_init(buffer);
+}
@@ -0,0 +1,58 @@
+/***********************************************************************
+ *  File name   : buffer.h
+ *  Description : Header file for the growable text buffer used to
+ *                format large outputs of the Inverted Search Project
+ *                in memory before writing them with a single fwrite.
+ *
+ *                Functions:
+ *                - buffer_init()
+ *                - buffer_append()
+ *                - buffer_append_str()
+ *                - buffer_append_int()
+ *                - buffer_free()
+ *
+ ***********************************************************************/
+
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stddef.h>
+
+/* TextBuffer:
+ * Growable byte buffer. A failed allocation sets failed and
+ * makes every later append a no-op.
+ */
+typedef struct TextBuffer
+{
+    char *data;
+    size_t length;             // Bytes used
+    size_t capacity;           // Bytes allocated
+    int failed;                // Set once an allocation failed
+} TextBuffer;
+
+/**
+ * Initializes an empty buffer.
+ */
+void buffer_init(TextBuffer *buffer);
+
+/**
+ * Appends length bytes.
+ */
+void buffer_append(TextBuffer *buffer, const char *text, size_t length);
+
+/**
+ * Appends a NUL-terminated string.
+ */
+void buffer_append_str(TextBuffer *buffer, const char *text);
+
+/**
+ * Appends a decimal integer.
+ */
+void buffer_append_int(TextBuffer *buffer, long value);
+
+/**
+ * Releases the buffer memory.
+ */
+void buffer_free(TextBuffer *buffer);
+
+#endif
@@ -6,19 +6,46 @@
  *
  ***********************************************************************/
 
+#include <sys/stat.h>
+
 #include "database.h"
+#include "postings.h"
+#include "parallel.h"
+#include "buffer.h"
+#include "dedup.h"
 
-/* Create database from input files and store words in hash table */
-int create_database(FileList *filelist, HashTable hashTablle[MAX_HASH_SIZE])
+/* Computes the MinHash signature of a file in a pass of its own */
+static void file_signature(FILE *fp, unsigned int signature[MINHASH_SIZE])
+{
+    char word[MAX_WORD_LENGTH];
+    unsigned long long previous = 0;
+    minhash_init(signature);
+    while(fscanf(fp, "%19s", word) == 1)
+        minhash_add(signature, minhash_shingle(&previous, word));
+}
+
+/* Create database from input files and store words in hash table.
+ * The MinHash signature of every file is built in the same pass; with
+ * collapse at ingest it is built first, and near-duplicates of files
+ * already indexed are skipped. */
+int create_database(FileList *filelist, HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, TermSketch *sketch)
 {
     if(filelist == NULL)
     {
         fprintf(stderr, "\nINFO: File List is Empty\n");
         return FAILURE;
     }
+    int collapse = collapse_at_ingest();
     FileList *temp = filelist;
     while(temp)
     {
+        // A file of an earlier update stays in the list, its words are in already
+        if(docTable_find_id(docs, temp->filename) != FAILURE)
+        {
+            printf("\nINFO: File %s is already in the DATABASE\n", temp->filename);
+            temp = temp->link;
+            continue;
+        }
         FILE *fp = fopen(temp->filename, "r");
         if (fp == NULL)
         {
@@ -26,18 +53,59 @@ int create_database(FileList *filelist, HashTable hashTablle[MAX_HASH_SIZE])
             temp = temp->link;
             continue; // skip this file
         }
+        unsigned int signature[MINHASH_SIZE];
+        unsigned long long previous = 0;
+        minhash_init(signature);
+        if (collapse)
+        {
+            double similarity;
+            file_signature(fp, signature);
+            int original = minhash_is_empty(signature) ? FAILURE :
+                docTable_find_near_duplicate(docs, signature, docTable_find_id(docs, temp->filename), NEAR_DUPLICATE_THRESHOLD, &similarity);
+            if (original != FAILURE)
+            {
+                printf("\nINFO: Skipping file %s, near-duplicate of %s (similarity ~%.2f)\n", temp->filename, docs->names[original], similarity);
+                fclose(fp);
+                temp = temp->link;
+                continue;
+            }
+            rewind(fp);
+        }
+        int docId = docTable_get_id(docs, temp->filename);
+        if (docId == FAILURE)
+        {
+            fprintf(stderr, "Error: Could not register file '%s'\n", temp->filename);
+            fclose(fp);
+            return FAILURE;
+        }
         char word[MAX_WORD_LENGTH];
+        int tokenCount = 0;
         while(fscanf(fp, "%19s", word) == 1)
         {
+            tokenCount++;
+            if (!collapse)
+                minhash_add(signature, minhash_shingle(&previous, word));
             int index = get_word_index(word);
             if (index < 0 || index >= MAX_HASH_SIZE)
             {
                 fprintf(stderr, "INFO: Skipping word '%s' (index %d out of range)\n", word, index);
                 continue;
             }
-            if (hashTable_insert_last(hashTablle, temp->filename, index, word) != SUCCESS)
+            if (hashTable_insert_last(hashTablle, temp->filename, docId, index, word) != SUCCESS)
                 fprintf(stderr, "INFO: Failed to insert word %s from file %s\n", word, temp->filename);
+            else if (sketch && termSketch_add(sketch, word, 1) == FAILURE)
+            {
+                fprintf(stderr, "Error: Could not count words of file '%s'\n", temp->filename);
+                fclose(fp);
+                return FAILURE;
+            }
         }
+        // Metadata columns used by filtered searches
+        struct stat info;
+        if(fstat(fileno(fp), &info) == 0)
+            docTable_set_metadata(docs, docId, (long long)info.st_size, (long long)info.st_mtime, tokenCount);
+        if(docTable_set_signature(docs, docId, signature) == FAILURE)
+            fprintf(stderr, "INFO: Could not index the signature of file %s\n", temp->filename);
         fclose(fp);
         printf("\nINFO: DATABASE successfully created for file %s\n", temp->filename);
         temp = temp->link;
@@ -46,7 +114,7 @@ int create_database(FileList *filelist, HashTable hashTablle[MAX_HASH_SIZE])
 }
 
 /* Display the contents of the database in a table format */
-void display_database(HashTable hashTablle[])
+void display_database(HashTable hashTablle[], DocTable *docs)
 {
     printf("====================================================================================\n");
     printf("| %-10s%-15s%15s%20s%20s |\n", "Index", "Word", "File Count", "File Name", "word Count");
@@ -57,15 +125,16 @@ void display_database(HashTable hashTablle[])
         {
             printf("|----------------------------------------------------------------------------------|\n");
             printf("| %-10d%-15s%15d", i, temp->word, temp->fileCount);
-            SubNode *temp_sub = temp->subLink;
-            for(int j = 0; j < temp->fileCount; j++)
+            PostingCursor cursor;
+            int docId, wordCount;
+            postingCursor_init(&cursor, temp);
+            for(int j = 0; postingCursor_next(&cursor, &docId, &wordCount); j++)
             {
                 if(j > 0)
                 {
                     printf("|%-40s ", "           ->");
                 }
-                printf("%20s%20d |\n", temp_sub->filename, temp_sub->wordCount);
-                temp_sub = temp_sub->subLink;
+                printf("%20s%20d |\n", docs->names[docId], wordCount);
             }
             temp = temp->mainLink;
         }
@@ -74,148 +143,687 @@ void display_database(HashTable hashTablle[])
 }
 
 /* Search for a given word in the database */
-void search_word(HashTable hashTablle[], char *word)
+void search_word(HashTable hashTablle[], DocTable *docs, char *word)
 {
     int index = get_word_index(word);
-    MainNode *temp_m = hashTablle[index].link;
-    int found = 0;
-    while(temp_m)
+    MainNode *temp_m = termTable_find(&hashTablle[index].terms, word);
+    if(temp_m == NULL)
     {
-        if(strcmp(temp_m->word, word) == 0)
+        printf("\nWord \"%s\" not present in the DATABASE\n", word);
+        return;
+    }
+    printf("\nWord '%s' is present in (%d) file\n", temp_m->word, temp_m->fileCount);
+    PostingCursor cursor;
+    int docId, wordCount;
+    postingCursor_init(&cursor, temp_m);
+    while(postingCursor_next(&cursor, &docId, &wordCount))
+        printf("In File : '%s' (%d) Time\n", docs->names[docId], wordCount);
+}
+
+/* Compare function used to sort document ids */
+static int compare_docId(const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+/* Collects up to max sorted document ids of a word, returns the count (0 if absent) */
+static int collect_docIds(MainNode *temp_m, unsigned int *ids, int max)
+{
+    if(temp_m == NULL)
+        return 0;
+    if(temp_m->docSet)
+        return roaring_to_array(temp_m->docSet, ids);
+
+    int count = 0;
+    for(SubNode *temp_s = temp_m->subLink; temp_s && count < max; temp_s = temp_s->subLink)
+        ids[count++] = temp_s->docId;
+    qsort(ids, count, sizeof(unsigned int), compare_docId);
+    return count;
+}
+
+/* Combines the id sets of words that all have dense postings, returns the count */
+static int combine_dense(MainNode *nodes[], int count, int matchAll, unsigned int *result)
+{
+    Roaring acc, next;
+    if((matchAll ? roaring_and : roaring_or)(nodes[0]->docSet, nodes[1]->docSet, &acc) == FAILURE)
+        return FAILURE;
+    for(int i = 2; i < count; i++)
+    {
+        if((matchAll ? roaring_and : roaring_or)(&acc, nodes[i]->docSet, &next) == FAILURE)
         {
-            found = 1;
-            printf("\nWord '%s' is present in (%d) file\n", temp_m->word, temp_m->fileCount);
-            SubNode *temp_s = temp_m->subLink;
-            for(int j = 0; j < temp_m->fileCount; j++)
-            {
-                printf("In File : '%s' (%d) Time\n", temp_s->filename, temp_s->wordCount);
-                temp_s = temp_s->subLink;
-            }
+            roaring_free(&acc);
+            return FAILURE;
         }
-        temp_m = temp_m->mainLink;
+        roaring_free(&acc);
+        acc = next;
     }
-    if(found == 0)
-        printf("\nWord \"%s\" not present in the DATABASE\n", word);
+    int resultCount = roaring_to_array(&acc, result);
+    roaring_free(&acc);
+    return resultCount;
 }
 
-/* Save the current database to a backup file */
-void save_database(HashTable hashTablle[], char *backup)
+/* Stores in result (room for docs->count ids) the sorted ids of the files
+ * containing all or any of the given words. Returns the count (0 for no
+ * words) or FAILURE. */
+int match_words(HashTable hashTablle[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll, unsigned int *result)
 {
-    if(valid_file_name(backup) == FAILURE)
+    if(count < 1)
+        return 0;
+    unsigned int *ids = malloc((docs->count + 1) * sizeof(unsigned int));
+    unsigned int *merged = malloc((docs->count + 1) * sizeof(unsigned int));
+    if(ids == NULL || merged == NULL)
     {
-        fprintf(stderr, "ERROR: Invalid File name\n");
-        return;
+        free(ids);
+        free(merged);
+        return FAILURE;
     }
-    FILE *fp = fopen(backup, "w");
-    if(fp == NULL)
+
+    MainNode *nodes[MAX_QUERY_WORDS];
+    int allDense = count > 1;
+    for(int i = 0; i < count; i++)
     {
-        fprintf(stderr, "Backup FILE with name %s Could not be created\n", backup);
-        return;
+        nodes[i] = termTable_find(&hashTablle[(int)get_word_index(words[i])].terms, words[i]);
+        if(nodes[i] == NULL || nodes[i]->docSet == NULL)
+            allDense = 0;
     }
-    fprintf(fp, "#%s;%s;%s;%s;%s;#\n", "Index", "Word", "FileCount", "FileName", "wordCount");
-    for(int i = 0; i < MAX_HASH_SIZE; i++)
+
+    int resultCount = FAILURE;
+    // Frequent words only → combine their bitmaps word by word
+    if(allDense)
+        resultCount = combine_dense(nodes, count, matchAll, result);
+    if(resultCount == FAILURE)
     {
-        MainNode *temp = hashTablle[i].link;
-        while(temp != NULL)
+        unsigned int *acc = result;
+        resultCount = collect_docIds(nodes[0], acc, docs->count);
+        for(int i = 1; i < count; i++)
         {
-            fprintf(fp,"#%d;%s;%d;", i, temp->word, temp->fileCount);
-            SubNode *temp_sub = temp->subLink;
-            for(int j = 0; j < temp->fileCount; j++)
-            {
-                fprintf(fp, "%s;%d;", temp_sub->filename, temp_sub->wordCount);
-                temp_sub = temp_sub->subLink;
-            }
-            fprintf(fp, "#\n");
-            temp = temp->mainLink;
+            if(matchAll && resultCount == 0)
+                break;
+            int idCount = collect_docIds(nodes[i], ids, docs->count);
+            if(matchAll)
+                resultCount = postings_intersect(acc, resultCount, ids, idCount, merged);
+            else
+                resultCount = postings_union(acc, resultCount, ids, idCount, merged);
+            unsigned int *swap = acc;
+            acc = merged;
+            merged = swap;
+        }
+        if(acc != result)
+        {
+            memcpy(result, acc, resultCount * sizeof(unsigned int));
+            merged = acc;
         }
     }
-    fclose(fp);
-    printf("\nINFO: Database saved successfully in file %s\n", backup);
+    free(ids);
+    free(merged);
+    return resultCount;
+}
+
+/* Search for files containing all or any of the given words */
+void search_words(HashTable hashTablle[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll)
+{
+    unsigned int *result = malloc((docs->count + 1) * sizeof(unsigned int));
+    int resultCount = result ? match_words(hashTablle, docs, words, count, matchAll, result) : FAILURE;
+    if(resultCount == FAILURE)
+        fprintf(stderr, "\nERROR: Could not allocate memory for search\n");
+    else if(resultCount == 0)
+        printf("\nNo file in the DATABASE contains %s of the given words\n", matchAll ? "all" : "any");
+    else
+    {
+        printf("\n%s of the given words present in (%d) file\n", matchAll ? "All" : "Some", resultCount);
+        for(int i = 0; i < resultCount; i++)
+            printf("In File : '%s'\n", docs->names[result[i]]);
+    }
+    free(result);
+}
+
+/* SaveJob:
+ * Shared by the bucket workers of save_database().
+ */
+typedef struct SaveJob
+{
+    HashTable *hashTable;
+    DocTable *docs;
+    TextBuffer buffers[MAX_HASH_SIZE];   // Formatted lines of each bucket
+} SaveJob;
+
+/* Formats every MainNode of one bucket into its own buffer */
+static int save_bucket(int index, void *arg)
+{
+    SaveJob *job = arg;
+    TextBuffer *out = &job->buffers[index];
+    for(MainNode *temp = job->hashTable[index].link; temp != NULL; temp = temp->mainLink)
+    {
+        buffer_append_str(out, "#");
+        buffer_append_int(out, index);
+        buffer_append_str(out, ";");
+        buffer_append_str(out, temp->word);
+        buffer_append_str(out, ";");
+        buffer_append_int(out, temp->fileCount);
+        buffer_append_str(out, ";");
+        PostingCursor cursor;
+        int docId, wordCount;
+        postingCursor_init(&cursor, temp);
+        while(postingCursor_next(&cursor, &docId, &wordCount))
+        {
+            buffer_append_str(out, job->docs->names[docId]);
+            buffer_append_str(out, ";");
+            buffer_append_int(out, wordCount);
+            buffer_append_str(out, ";");
+        }
+        buffer_append_str(out, "#\n");
+    }
+    return out->failed ? FAILURE : SUCCESS;
 }
 
-/* Update database from a backup file and merge with new file list */
-void update_database(FileList **filelist, HashTable hashTablle[], char *backup)
+/* Save the current database to a backup file.
+ * Buckets are formatted concurrently and written in index order,
+ * so the file is the same for any number of threads. */
+void save_database(HashTable hashTablle[], DocTable *docs, char *backup)
 {
     if(valid_file_name(backup) == FAILURE)
     {
-        fprintf(stderr, " ERROR: Invalid File name\n");
+        fprintf(stderr, "ERROR: Invalid File name\n");
         return;
     }
-    FILE *fp = fopen(backup, "r");
-    if(get_file_size(fp) == 0)
+
+    SaveJob *job = malloc(sizeof(SaveJob));
+    if(job == NULL)
     {
-        fprintf(stderr, " ERROR: %s file is empty\n", backup);
+        fprintf(stderr, "ERROR: Could not allocate memory to save the Database\n");
         return;
     }
-    if(valid_database(fp) == FAILURE)
+    job->hashTable = hashTablle;
+    job->docs = docs;
+    for(int i = 0; i < MAX_HASH_SIZE; i++)
+        buffer_init(&job->buffers[i]);
+
+    int status = parallel_for(MAX_HASH_SIZE, get_thread_count(), save_bucket, job);
+    FILE *fp = NULL;
+    if(status == FAILURE)
+        fprintf(stderr, "ERROR: Could not allocate memory to save the Database\n");
+    else if((fp = fopen(backup, "w")) == NULL)
     {
-        fprintf(stderr, " ERROR: %s file is not a DATABASE file\n", backup);
-        return;
+        fprintf(stderr, "Backup FILE with name %s Could not be created\n", backup);
+        status = FAILURE;
     }
-    int index, fileCount; 
+    else
+    {
+        fprintf(fp, "#%s;%s;%s;%s;%s;#\n", "Index", "Word", "FileCount", "FileName", "wordCount");
+        for(int i = 0; i < MAX_HASH_SIZE; i++)
+        {
+            TextBuffer *buffer = &job->buffers[i];
+            if(buffer->length && fwrite(buffer->data, 1, buffer->length, fp) != buffer->length)
+                status = FAILURE;
+        }
+        if(fclose(fp) != 0 || status == FAILURE)
+        {
+            fprintf(stderr, "ERROR: Could not write Backup FILE %s\n", backup);
+            status = FAILURE;
+        }
+    }
+
+    for(int i = 0; i < MAX_HASH_SIZE; i++)
+        buffer_free(&job->buffers[i]);
+    free(job);
+    if(status == SUCCESS)
+        printf("\nINFO: Database saved successfully in file %s\n", backup);
+}
+
+/* LoadJob:
+ * A backup file read into memory and split into lines, shared by
+ * the bucket workers of update_database().
+ */
+typedef struct LoadJob
+{
+    HashTable *hashTable;
+    char **lines;              // Start of each line (NUL-terminated, after the index)
+    MainNode **nodes;          // MainNode parsed from each line, NULL if invalid
+    MainNode **targets;        // Indexed MainNode of the same word, the line is merged into it
+    int *files;                // Document ids of the backup, by first appearance
+    int fileCount;
+    int *order;                // Line numbers grouped by bucket, in file order
+    int bucketStart[MAX_HASH_SIZE + 1];  // First entry of each bucket in order
+} LoadJob;
+
+/* Copies the text up to the next ';' into field (at most size - 1 chars).
+ * Returns the position after the ';', or NULL if there is none or the
+ * text is too long. */
+static char *parse_field(char *p, char *field, int size)
+{
+    char *end = strchr(p, ';');
+    if(end == NULL || end - p >= size || end == p)
+        return NULL;
+    memcpy(field, p, end - p);
+    field[end - p] = '\0';
+    return end + 1;
+}
+
+/* Reads a number followed by ';'. Returns the position after it, or NULL */
+static char *parse_count(char *p, int *value)
+{
+    char *end;
+    long number = strtol(p, &end, 10);
+    if(end == p || *end != ';' || number < 0 || number > 0x7FFFFFFF)
+        return NULL;
+    *value = (int)number;
+    return end + 1;
+}
+
+/* Parses "word;fileCount;name;count;...;#" into a MainNode whose
+ * SubNodes have no document id yet. Returns NULL for a malformed line. */
+static MainNode *parse_backup_line(char *p)
+{
     char word[MAX_WORD_LENGTH];
+    char filename[MAX_FILENAME_LENGTH];
+    int fileCount, wordCount;
 
-    fscanf(fp, "%*[^\n]");
-    fgetc(fp);
-    while(fscanf(fp, "#%d;%[^;];%d;", &index, word, &fileCount) == 3)
-    {
-        MainNode *curr_m = hashTablle[index].link;
-        MainNode *prev_m = NULL;
+    if((p = parse_field(p, word, MAX_WORD_LENGTH)) == NULL || (p = parse_count(p, &fileCount)) == NULL)
+        return NULL;
+    MainNode *newMain = create_mainNode(word, fileCount);
+    if(newMain == NULL)
+        return NULL;
 
-        while(curr_m)
+    SubNode *temp_s = NULL;
+    for(int i = 0; i < fileCount && newMain; i++)
+    {
+        SubNode *newSub = NULL;
+        if((p = parse_field(p, filename, MAX_FILENAME_LENGTH)) != NULL && (p = parse_count(p, &wordCount)) != NULL)
+            newSub = create_subNode(filename, FAILURE, wordCount);
+        if(newSub == NULL)
         {
-            prev_m = curr_m;
-            curr_m = curr_m->mainLink;
+            free_mainNode(newMain);
+            return NULL;
         }
-        MainNode *newMain = create_mainNode(word, fileCount);
-        if(newMain == NULL)
+        if(temp_s)
+            temp_s->subLink = newSub;
+        else
+            newMain->subLink = newSub;
+        temp_s = newSub;
+    }
+    if(*p != '#')
+    {
+        free_mainNode(newMain);
+        return NULL;
+    }
+    return newMain;
+}
+
+/* Parses every line of one bucket and appends the MainNodes in file order;
+ * a word already indexed gets a target to be merged into once the
+ * document ids are known */
+static int load_bucket(int index, void *arg)
+{
+    LoadJob *job = arg;
+    int first = job->bucketStart[index], last = job->bucketStart[index + 1];
+    if(first == last)
+        return SUCCESS;
+
+    HashTable *bucket = &job->hashTable[index];
+    if(termTable_reserve(&bucket->terms, bucket->terms.size + last - first) == FAILURE)
+        return FAILURE;
+    for(int k = first; k < last; k++)
+    {
+        int line = job->order[k];
+        job->nodes[line] = parse_backup_line(job->lines[line]);
+        if(job->nodes[line] == NULL)
+            continue;
+        if((job->targets[line] = termTable_find(&bucket->terms, job->nodes[line]->word)) != NULL)
+            continue;
+        if(hashTable_link_mainNode(job->hashTable, index, job->nodes[line]) == FAILURE)
         {
-            fprintf(stderr, "\n ERROR: Could not create Database\n");
-            return;
+            free_mainNode(job->nodes[line]);
+            job->nodes[line] = NULL;
+            return FAILURE;
         }
-        if(prev_m)
-            prev_m->mainLink = newMain;
+    }
+    return SUCCESS;
+}
+
+/* Orders the postings of the new words of one bucket by document id and
+ * merges the other lines into the words already indexed */
+static int merge_bucket(int index, void *arg)
+{
+    LoadJob *job = arg;
+    for(int k = job->bucketStart[index]; k < job->bucketStart[index + 1]; k++)
+    {
+        int line = job->order[k];
+        if(job->nodes[line] == NULL)
+            continue;
+        if(job->targets[line] == NULL)
+            mainNode_sort_postings(job->nodes[line]);
         else
-            hashTablle[index].link = newMain;
+        {
+            MainNode *node = job->nodes[line];
+            job->nodes[line] = NULL;
+            if(mainNode_merge(job->targets[line], node) == FAILURE)
+                return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/* Switches the frequent words of one bucket to dense postings */
+static int densify_bucket(int index, void *arg)
+{
+    LoadJob *job = arg;
+    for(int k = job->bucketStart[index]; k < job->bucketStart[index + 1]; k++)
+    {
+        MainNode *node = job->nodes[job->order[k]];
+        if(node && node->docSet == NULL && node->fileCount > DENSE_POSTING_THRESHOLD && mainNode_make_dense(node) == FAILURE)
+            return FAILURE;
+    }
+    return SUCCESS;
+}
 
-        SubNode *temp_s = newMain->subLink;
+/* Reads a whole file into a NUL-terminated buffer */
+static char *read_whole_file(FILE *fp, size_t *size)
+{
+    *size = get_file_size(fp);
+    char *data = malloc(*size + 1);
+    if(data == NULL)
+        return NULL;
+    rewind(fp);
+    if(fread(data, 1, *size, fp) != *size)
+    {
+        free(data);
+        return NULL;
+    }
+    data[*size] = '\0';
+    return data;
+}
 
-        int wordCount;
-        char filename[MAX_FILENAME_LENGTH];
+/* Pushes a file position on a min-heap */
+static void heap_push(int *heap, int *size, int value)
+{
+    int pos = (*size)++;
+    while(pos > 0 && heap[(pos - 1) / 2] > value)
+    {
+        heap[pos] = heap[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    heap[pos] = value;
+}
 
-        for(int i = 0; i < fileCount; i++)
+/* Pops the smallest file position of a min-heap */
+static int heap_pop(int *heap, int *size)
+{
+    int top = heap[0], last = heap[--*size], pos = 0;
+    for(;;)
+    {
+        int child = 2 * pos + 1;
+        if(child >= *size)
+            break;
+        if(child + 1 < *size && heap[child + 1] < heap[child])
+            child++;
+        if(heap[child] >= last)
+            break;
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = last;
+    return top;
+}
+
+/* Assigns document ids to the files of the backup. Every line lists its
+ * files in id order, so new files are numbered in an order agreeing with
+ * all lines (ties by first appearance): saving the loaded database then
+ * writes every line as it was read. */
+static int resolve_docIds(LoadJob *job, int lineCount, DocTable *docs)
+{
+    DocTable files;            // Files not in docs yet, by first appearance
+    int postings = 0, status = SUCCESS;
+    initialize_docTable(&files);
+    for(int line = 0; line < lineCount && status == SUCCESS; line++)
+    {
+        for(SubNode *temp_s = job->nodes[line] ? job->nodes[line]->subLink : NULL; temp_s; temp_s = temp_s->subLink)
         {
-            fscanf(fp, "%[^;];%d;", filename, &wordCount);
+            postings++;
+            if(docTable_find_id(docs, temp_s->filename) == FAILURE && docTable_get_id(&files, temp_s->filename) == FAILURE)
+                status = FAILURE;
+        }
+    }
 
-            if(delete_duplicate(filelist, filename) == SUCCESS)
-            {
-                printf("\nINFO: Deleting File %s in FileList (already present in the database file %s)\n", filename, backup);
-                print_fileList(*filelist);
-            }
-            SubNode *newSub = create_subNode(filename, wordCount);
-            if(newSub == NULL)
-            {
-                fprintf(stderr, "\n ERROR: Could not create Database\n");
-                return;
-            }
-            if(i == 0)
+    // One edge per pair of new files that follow each other in a line
+    int count = files.count, edgeCount = 0, heapSize = 0;
+    int *from = malloc((postings + 1) * sizeof(int));
+    int *to = malloc((postings + 1) * sizeof(int));
+    int *targets = malloc((postings + 1) * sizeof(int));
+    int *start = calloc(count + 2, sizeof(int));
+    int *indegree = calloc(count + 1, sizeof(int));
+    int *heap = malloc((count + 1) * sizeof(int));
+    if(from == NULL || to == NULL || targets == NULL || start == NULL || indegree == NULL || heap == NULL)
+        status = FAILURE;
+    for(int line = 0; line < lineCount && status == SUCCESS; line++)
+    {
+        int previous = FAILURE;
+        for(SubNode *temp_s = job->nodes[line] ? job->nodes[line]->subLink : NULL; temp_s; temp_s = temp_s->subLink)
+        {
+            int id = docTable_find_id(&files, temp_s->filename);
+            if(id == FAILURE)
+                continue;
+            if(previous != FAILURE && previous != id)
             {
-                newMain->subLink = newSub;
-                temp_s = newSub;
+                from[edgeCount] = previous;
+                to[edgeCount++] = id;
+                start[previous + 1]++;
+                indegree[id]++;
             }
-            else
+            previous = id;
+        }
+    }
+
+    if(status == SUCCESS)
+    {
+        for(int i = 0; i < count; i++)
+            start[i + 1] += start[i];
+        for(int e = 0; e < edgeCount; e++)
+            targets[start[from[e]]++] = to[e];
+        for(int i = count; i > 0; i--)
+            start[i] = start[i - 1];
+        start[0] = 0;
+
+        // Kahn's algorithm; a cycle (edited backup) is broken at its first file
+        for(int i = 0; i < count; i++)
+            if(indegree[i] == 0)
+                heap_push(heap, &heapSize, i);
+        for(int placed = 0, next = 0; placed < count && status == SUCCESS; placed++)
+        {
+            if(heapSize == 0)
             {
-                temp_s->subLink = newSub;
-                temp_s = newSub;
+                while(indegree[next] < 0)
+                    next++;
+                heap_push(heap, &heapSize, next);
             }
+            int file = heap_pop(heap, &heapSize);
+            indegree[file] = -1;
+            if(docTable_get_id(docs, files.names[file]) == FAILURE)
+                status = FAILURE;
+            for(int e = start[file]; e < start[file + 1]; e++)
+                if(indegree[targets[e]] > 0 && --indegree[targets[e]] == 0)
+                    heap_push(heap, &heapSize, targets[e]);
         }
-        fscanf(fp, "#\n");
     }
+
+    // Ids of the postings, and the files of the backup by first appearance
+    unsigned char *seen = status == SUCCESS ? calloc(docs->count + 1, 1) : NULL;
+    job->files = seen ? malloc((postings + 1) * sizeof(int)) : NULL;
+    job->fileCount = 0;
+    if(job->files == NULL)
+        status = FAILURE;
+    for(int line = 0; line < lineCount && status == SUCCESS; line++)
+    {
+        for(SubNode *temp_s = job->nodes[line] ? job->nodes[line]->subLink : NULL; temp_s; temp_s = temp_s->subLink)
+        {
+            temp_s->docId = docTable_find_id(docs, temp_s->filename);
+            if(!seen[temp_s->docId])
+                job->files[job->fileCount++] = temp_s->docId;
+            seen[temp_s->docId] = 1;
+        }
+    }
+    free(seen);
+    free(from);
+    free(to);
+    free(targets);
+    free(start);
+    free(indegree);
+    free(heap);
+    free_docTable(&files);
+    return status;
+}
+
+/* Drops the backed up files from the FileList, once the load succeeded */
+static void drop_backed_up_files(LoadJob *job, FileList **filelist, DocTable *docs, char *backup)
+{
+    for(int i = 0; i < job->fileCount; i++)
+    {
+        if(delete_duplicate(filelist, docs->names[job->files[i]]) == SUCCESS)
+        {
+            printf("\nINFO: Deleting File %s in FileList (already present in the database file %s)\n", docs->names[job->files[i]], backup);
+            print_fileList(*filelist);
+        }
+    }
+}
+
+/* Update database from a backup file and merge with new file list.
+ * The file is split into lines by bucket; buckets are parsed
+ * concurrently into pre-sized term tables. On FAILURE the tables may
+ * hold part of the backup and must be discarded. */
+int update_database(FileList **filelist, HashTable hashTablle[], DocTable *docs, TermSketch *sketch, char *backup)
+{
+    if(valid_file_name(backup) == FAILURE)
+    {
+        fprintf(stderr, " ERROR: Invalid File name\n");
+        return FAILURE;
+    }
+    FILE *fp = fopen(backup, "r");
+    if(fp == NULL)
+    {
+        fprintf(stderr, " ERROR: %s file could not be opened\n", backup);
+        return FAILURE;
+    }
+    if(get_file_size(fp) == 0)
+    {
+        fprintf(stderr, " ERROR: %s file is empty\n", backup);
+        fclose(fp);
+        return FAILURE;
+    }
+    if(valid_database(fp) == FAILURE)
+    {
+        fprintf(stderr, " ERROR: %s file is not a DATABASE file\n", backup);
+        fclose(fp);
+        return FAILURE;
+    }
+    size_t size;
+    char *data = read_whole_file(fp, &size);
     fclose(fp);
-    if(create_database(*filelist, hashTablle) == FAILURE)
+
+    // Split into lines (skipping the header) and count lines per bucket
+    int lineCount = 0;
+    for(size_t i = 0; i < size; i++)
+        lineCount += data != NULL && data[i] == '\n';
+    LoadJob job;
+    job.hashTable = hashTablle;
+    job.lines = malloc((lineCount + 1) * sizeof(char *));
+    job.nodes = calloc(lineCount + 1, sizeof(MainNode *));
+    job.targets = calloc(lineCount + 1, sizeof(MainNode *));
+    job.files = NULL;
+    job.order = malloc((lineCount + 1) * sizeof(int));
+    int *lineIndex = malloc((lineCount + 1) * sizeof(int));
+    if(data == NULL || job.lines == NULL || job.nodes == NULL || job.targets == NULL || job.order == NULL || lineIndex == NULL)
+    {
+        fprintf(stderr, "\n ERROR: Could not create Database\n");
+        free(data);
+        free(job.lines);
+        free(job.nodes);
+        free(job.targets);
+        free(job.order);
+        free(lineIndex);
+        return FAILURE;
+    }
+
+    int counts[MAX_HASH_SIZE] = {0};
+    int lines = 0, skipped = 0;
+    char *p = strchr(data, '\n');
+    while(p != NULL && *++p != '\0')
+    {
+        char *next = strchr(p, '\n');
+        if(next)
+            *next = '\0';
+        char *end;
+        long index = strtol(p + 1, &end, 10);
+        if(*p != '#' || end == p + 1 || *end != ';' || index < 0 || index >= MAX_HASH_SIZE)
+            skipped++;
+        else
+        {
+            job.lines[lines] = end + 1;
+            lineIndex[lines] = (int)index;
+            counts[index]++;
+            lines++;
+        }
+        p = next;
+    }
+
+    // Group line numbers by bucket, keeping file order inside a bucket
+    job.bucketStart[0] = 0;
+    for(int i = 0; i < MAX_HASH_SIZE; i++)
+        job.bucketStart[i + 1] = job.bucketStart[i] + counts[i];
+    int fill[MAX_HASH_SIZE];
+    memcpy(fill, job.bucketStart, sizeof(fill));
+    for(int line = 0; line < lines; line++)
+        job.order[fill[lineIndex[line]]++] = line;
+    free(lineIndex);
+
+    int threads = get_thread_count();
+    int status = parallel_for(MAX_HASH_SIZE, threads, load_bucket, &job);
+    for(int line = 0; line < lines; line++)
+        skipped += job.nodes[line] == NULL;
+    if(status == SUCCESS)
+        status = resolve_docIds(&job, lines, docs);
+    // Loaded words count towards the ingest sketch with their total occurrences
+    for(int line = 0; line < lines && status == SUCCESS && sketch; line++)
+    {
+        MainNode *node = job.nodes[line];
+        if(node == NULL)
+            continue;
+        long long total = 0;
+        for(SubNode *temp_s = node->subLink; temp_s; temp_s = temp_s->subLink)
+            total += temp_s->wordCount;
+        if(termSketch_add(sketch, node->word, total) == FAILURE)
+            status = FAILURE;
+    }
+    if(status == SUCCESS)
+        status = parallel_for(MAX_HASH_SIZE, threads, merge_bucket, &job);
+    if(status == SUCCESS)
+        status = parallel_for(MAX_HASH_SIZE, threads, densify_bucket, &job);
+    if(status == SUCCESS)
+        drop_backed_up_files(&job, filelist, docs, backup);
+
+    // Lines not merged into an indexed word (after a failure) are not in the tables
+    for(int line = 0; line < lines; line++)
+        if(job.targets[line] && job.nodes[line])
+            free_mainNode(job.nodes[line]);
+    free(data);
+    free(job.lines);
+    free(job.nodes);
+    free(job.targets);
+    free(job.files);
+    free(job.order);
+    if(status == FAILURE)
+    {
+        fprintf(stderr, "\n ERROR: Could not create Database\n");
+        return FAILURE;
+    }
+    if(skipped)
+        fprintf(stderr, "\nINFO: Skipped %d malformed line(s) in %s\n", skipped, backup);
+
+    // Every input file may already be in the backup
+    if(*filelist && create_database(*filelist, hashTablle, docs, sketch) == FAILURE)
     {
         printf("\nINFO: Database could not be Updated\n");
-        return;
+        return FAILURE;
     }
     printf("\nINFO: Database Successfully Updated\n");
+    return SUCCESS;
 }
\ No newline at end of file
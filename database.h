@@ -2,7 +2,8 @@
  *  File name   : database.h
  *  Description : Header file for database operations in the Inverted Search project.
  *                Provides function prototypes for creating, displaying, 
- *                searching, saving, and updating the database.
+ *                searching (single and multiple words), saving, and
+ *                updating the database.
  *
  ***********************************************************************/
 
@@ -11,20 +12,32 @@
 
 #include "list.h"
 #include "validate.h"
+#include "docs.h"
+#include "stats.h"
 
-/* Create the database (hash table) from given file list */
-int create_database(FileList *filelist, HashTable hashTable[MAX_HASH_SIZE]);
+/* Create the database (hash table) from given file list, counting every
+ * word in sketch as well (sketch may be NULL) and recording the MinHash
+ * signature of every file */
+int create_database(FileList *filelist, HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, TermSketch *sketch);
 
 /* Display the contents of the database */
-void display_database(HashTable hashTable[]);
+void display_database(HashTable hashTable[], DocTable *docs);
 
 /* Search for a word in the database */
-void search_word(HashTable hashTable[], char *word);
+void search_word(HashTable hashTable[], DocTable *docs, char *word);
+
+/* Store the sorted ids of the files containing all (matchAll = 1) or any of
+ * the given words in result (room for docs->count ids), returns the count */
+int match_words(HashTable hashTable[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll, unsigned int *result);
+
+/* Search for files containing all (matchAll = 1) or any of the given words */
+void search_words(HashTable hashTable[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll);
 
 /* Save the database to a backup file */
-void save_database(HashTable hashTable[], char *backup);
+void save_database(HashTable hashTable[], DocTable *docs, char *backup);
 
-/* Update the database with new files and save changes */
-void update_database(FileList **filelist, HashTable hashTable[], char *backup);
+/* Update the database with new files and save changes. Returns SUCCESS,
+ * or FAILURE, after which the tables may hold part of the update */
+int update_database(FileList **filelist, HashTable hashTable[], DocTable *docs, TermSketch *sketch, char *backup);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+/***********************************************************************
+ *  File name   : dedup.c
+ *  Description : Implementation file for near-duplicate detection of
+ *                the Inverted Search Project.
+ *
+ *                Functions:
+ *                - collapse_at_ingest()
+ *                - print_near_duplicates()
+ *                - search_words_collapsed()
+ *
+ ***********************************************************************/
+
+#include "dedup.h"
+#include "database.h"
+
+int collapse_at_ingest(void)
+{
+    char *env = getenv(COLLAPSE_ENV);
+    return env != NULL && atoi(env) == 1;
+}
+
+/* Returns the group of a file, halving the path on the way */
+static int find_group(int *parent, int id)
+{
+    while (parent[id] != id)
+    {
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+/**
+ * Joins every LSH candidate pair above threshold, keeping the lowest
+ * id as the group root, then prints the groups in id order.
+ */
+void print_near_duplicates(DocTable *docs, double threshold)
+{
+    if (threshold <= 0 || threshold > 1)
+    {
+        fprintf(stderr, "\nERROR: Similarity threshold must be greater than 0 and at most 1\n");
+        return;
+    }
+    int *parent = malloc((docs->count + 1) * sizeof(int));
+    int *next = malloc((docs->count + 1) * sizeof(int));
+    int *tail = malloc((docs->count + 1) * sizeof(int));
+    if (parent == NULL || next == NULL || tail == NULL)
+    {
+        fprintf(stderr, "\nERROR: Could not allocate memory for near-duplicate search\n");
+        free(parent);
+        free(next);
+        free(tail);
+        return;
+    }
+    for (int i = 0; i < docs->count; i++)
+        parent[i] = i;
+
+    int unsignedFiles = 0, pairs = 0, status = SUCCESS;
+    for (int d = 0; d < docs->count && status == SUCCESS; d++)
+    {
+        if (minhash_is_empty(docs->signatures[d]))
+        {
+            unsignedFiles += docs->tokenCounts[d] != 0;
+            continue;
+        }
+        int *ids;
+        int count = lsh_candidates(&docs->lsh, docs->signatures[d], &ids);
+        if (count == FAILURE)
+        {
+            status = FAILURE;
+            break;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (ids[i] <= d || minhash_similarity(docs->signatures[d], docs->signatures[ids[i]]) < threshold)
+                continue;
+            int a = find_group(parent, d), b = find_group(parent, ids[i]);
+            if (a != b)
+                parent[a > b ? a : b] = a < b ? a : b;
+            pairs++;
+        }
+        free(ids);
+    }
+
+    // Chain the members of each group behind its root
+    int groups = 0, files = 0;
+    for (int i = 0; i < docs->count && status == SUCCESS; i++)
+    {
+        int root = find_group(parent, i);
+        next[i] = FAILURE;
+        tail[i] = i;
+        if (root != i)
+        {
+            next[tail[root]] = i;
+            tail[root] = i;
+            groups += next[root] == i;
+            files += 1 + (next[root] == i);
+        }
+    }
+
+    if (status == FAILURE)
+        fprintf(stderr, "\nERROR: Could not allocate memory for near-duplicate search\n");
+    else if (groups == 0)
+        printf("\nNo near-duplicate files (similarity >= %.2f)\n", threshold);
+    else
+    {
+        printf("\n%d group(s) of near-duplicate files (similarity >= %.2f): %d file(s), %d similar pair(s)\n",
+               groups, threshold, files, pairs);
+        for (int i = 0, group = 0; i < docs->count; i++)
+        {
+            if (parent[i] != i || next[i] == FAILURE)
+                continue;
+            int size = 1;
+            for (int m = next[i]; m != FAILURE; m = next[m])
+                size++;
+            printf("Group %d (%d files):\n  '%s'\n", ++group, size, docs->names[i]);
+            for (int m = next[i]; m != FAILURE; m = next[m])
+                printf("  '%s' ~%.2f\n", docs->names[m], minhash_similarity(docs->signatures[i], docs->signatures[m]));
+        }
+    }
+    if (unsignedFiles)
+        fprintf(stderr, "\nINFO: %d file(s) loaded without a signature (text backup or older packed file) were not compared\n", unsignedFiles);
+    free(parent);
+    free(next);
+    free(tail);
+}
+
+/* Returns the position of id in the sorted ids[0..count), or FAILURE */
+static int find_position(unsigned int *ids, int count, unsigned int id)
+{
+    int lo = 0, hi = count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (ids[mid] < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < count && ids[lo] == id ? lo : FAILURE;
+}
+
+/**
+ * Each result joins the most similar earlier representative among its
+ * LSH candidates, or becomes a representative itself.
+ */
+void search_words_collapsed(HashTable hashTablle[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll)
+{
+    unsigned int *result = malloc((docs->count + 1) * sizeof(unsigned int));
+    int *group = malloc((docs->count + 1) * sizeof(int));
+    int *next = malloc((docs->count + 1) * sizeof(int));
+    int *tail = malloc((docs->count + 1) * sizeof(int));
+    int resultCount = result && group && next && tail ? match_words(hashTablle, docs, words, count, matchAll, result) : FAILURE;
+
+    int groups = 0, unsignedFiles = 0;
+    for (int i = 0; i < resultCount; i++)
+    {
+        unsigned int *signature = docs->signatures[result[i]];
+        group[i] = i;
+        next[i] = FAILURE;
+        tail[i] = i;
+        int *ids = NULL;
+        int candidates = 0;
+        if (!minhash_is_empty(signature))
+            candidates = lsh_candidates(&docs->lsh, signature, &ids);
+        else
+            unsignedFiles += docs->tokenCounts[result[i]] != 0;
+        if (candidates == FAILURE)
+        {
+            resultCount = FAILURE;
+            break;
+        }
+        double best = NEAR_DUPLICATE_THRESHOLD;
+        for (int c = 0; c < candidates; c++)
+        {
+            int position = find_position(result, i, (unsigned int)ids[c]);
+            if (position == FAILURE || group[position] != position)
+                continue;
+            double similarity = minhash_similarity(signature, docs->signatures[ids[c]]);
+            if (similarity > best || (similarity == best && group[i] == i))
+            {
+                group[i] = position;
+                best = similarity;
+            }
+        }
+        free(ids);
+        if (group[i] == i)
+            groups++;
+        else
+        {
+            next[tail[group[i]]] = i;
+            tail[group[i]] = i;
+        }
+    }
+
+    if (resultCount == FAILURE)
+        fprintf(stderr, "\nERROR: Could not allocate memory for search\n");
+    else if (resultCount == 0)
+        printf("\nNo file in the DATABASE contains %s of the given words\n", matchAll ? "all" : "any");
+    else
+    {
+        printf("\n%s of the given words present in (%d) file, %d after collapsing near-duplicates\n",
+               matchAll ? "All" : "Some", resultCount, groups);
+        for (int i = 0; i < resultCount; i++)
+        {
+            if (group[i] != i)
+                continue;
+            printf("In File : '%s'", docs->names[result[i]]);
+            if (next[i] != FAILURE)
+            {
+                int similar = 0;
+                for (int m = next[i]; m != FAILURE; m = next[m])
+                    similar++;
+                printf(" (+%d near-duplicate(s):", similar);
+                for (int m = next[i]; m != FAILURE; m = next[m])
+                    printf(" '%s'", docs->names[result[m]]);
+                printf(")");
+            }
+            printf("\n");
+        }
+    }
+    if (resultCount > 0 && unsignedFiles)
+        fprintf(stderr, "\nINFO: %d file(s) loaded without a signature (text backup or older packed file) were not collapsed\n", unsignedFiles);
+    free(result);
+    free(group);
+    free(next);
+    free(tail);
+}
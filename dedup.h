@@ -0,0 +1,51 @@
+/***********************************************************************
+ *  File name   : dedup.h
+ *  Description : Header file for near-duplicate detection of the
+ *                Inverted Search Project.
+ *                Near-duplicates are found through the MinHash
+ *                signatures and the LSH index of the document table:
+ *                only files sharing a signature band are compared.
+ *                They can be listed, collapsed in search results (one
+ *                representative per group) or, when COLLAPSE_ENV is
+ *                set to 1, skipped at ingest so they never reach the
+ *                posting lists. Signatures are kept in packed files but
+ *                not in the text backup format: files loaded from a
+ *                text backup are never compared (until indexed again),
+ *                and the listing and the collapsed search report them.
+ *
+ *                Functions:
+ *                - collapse_at_ingest()
+ *                - print_near_duplicates()
+ *                - search_words_collapsed()
+ *
+ ***********************************************************************/
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "list.h"
+#include "docs.h"
+
+#define NEAR_DUPLICATE_THRESHOLD 0.8     // Default estimated similarity of near-duplicates
+#define COLLAPSE_ENV "INVERTED_SEARCH_COLLAPSE_DUPLICATES"   // 1 to skip near-duplicates at ingest
+
+/**
+ * Returns 1 if COLLAPSE_ENV asks to skip near-duplicate files while
+ * creating the database.
+ */
+int collapse_at_ingest(void);
+
+/**
+ * Prints the groups of files whose estimated similarity is at least
+ * threshold, linking files through any similar pair, each file with
+ * its similarity to the first file of its group.
+ */
+void print_near_duplicates(DocTable *docs, double threshold);
+
+/**
+ * Searches like search_words(), printing one file per group of
+ * near-duplicate results along with the files it stands for.
+ */
+void search_words_collapsed(HashTable hashTable[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll);
+
+#endif
@@ -0,0 +1,225 @@
+/***********************************************************************
+ *  File name   : docs.c
+ *  Description : Implementation file for the document table of the
+ *                Inverted Search Project.
+ *
+ *                Functions:
+ *                - initialize_docTable()
+ *                - docTable_get_id()
+ *                - docTable_find_id()
+ *                - docTable_set_metadata()
+ *                - docTable_set_signature()
+ *                - docTable_find_near_duplicate()
+ *                - docTable_clone()
+ *                - free_docTable()
+ *
+ ***********************************************************************/
+
+#include "docs.h"
+
+/**
+ * Initializes an empty document table.
+ */
+void initialize_docTable(DocTable *docs)
+{
+    docs->names = NULL;
+    docs->count = 0;
+    docs->capacity = 0;
+    docs->slots = NULL;
+    docs->slotCount = 0;
+    docs->sizes = NULL;
+    docs->mtimes = NULL;
+    docs->tokenCounts = NULL;
+    docs->signatures = NULL;
+    lsh_init(&docs->lsh);
+}
+
+/**
+ * Returns the slot holding filename, or the free slot where it belongs.
+ */
+static int find_slot(DocTable *docs, char *filename)
+{
+    int mask = docs->slotCount - 1;
+    int slot = (int)(term_hash(filename) & mask);
+    while (docs->slots[slot] && strcmp(docs->names[docs->slots[slot] - 1], filename) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+/**
+ * Doubles the name index and re-inserts every document.
+ */
+static int grow_slots(DocTable *docs)
+{
+    int slotCount = docs->slotCount ? docs->slotCount * 2 : 32;
+    int *slots = calloc(slotCount, sizeof(int));
+    if (slots == NULL)
+        return FAILURE;
+    free(docs->slots);
+    docs->slots = slots;
+    docs->slotCount = slotCount;
+    for (int i = 0; i < docs->count; i++)
+        docs->slots[find_slot(docs, docs->names[i])] = i + 1;
+    return SUCCESS;
+}
+
+/**
+ * Returns the id of an already registered file, or FAILURE.
+ */
+int docTable_find_id(DocTable *docs, char *filename)
+{
+    if (docs->count == 0)
+        return FAILURE;
+    int slot = docs->slots[find_slot(docs, filename)];
+    return slot ? slot - 1 : FAILURE;
+}
+
+/**
+ * Returns the id of a file, appending it to the table if it
+ * has not been seen before.
+ */
+int docTable_get_id(DocTable *docs, char *filename)
+{
+    int id = docTable_find_id(docs, filename);
+    if (id != FAILURE)
+        return id;
+
+    if (docs->count == docs->capacity)
+    {
+        // Each array keeps its new block even if a later one fails
+        int capacity = docs->capacity ? docs->capacity * 2 : 16;
+        char (*names)[MAX_FILENAME_LENGTH] = realloc(docs->names, capacity * sizeof(*names));
+        if (names == NULL)
+            return FAILURE;
+        docs->names = names;
+        long long *sizes = realloc(docs->sizes, capacity * sizeof(long long));
+        if (sizes == NULL)
+            return FAILURE;
+        docs->sizes = sizes;
+        long long *mtimes = realloc(docs->mtimes, capacity * sizeof(long long));
+        if (mtimes == NULL)
+            return FAILURE;
+        docs->mtimes = mtimes;
+        int *tokenCounts = realloc(docs->tokenCounts, capacity * sizeof(int));
+        if (tokenCounts == NULL)
+            return FAILURE;
+        docs->tokenCounts = tokenCounts;
+        unsigned int (*signatures)[MINHASH_SIZE] = realloc(docs->signatures, capacity * sizeof(*signatures));
+        if (signatures == NULL)
+            return FAILURE;
+        docs->signatures = signatures;
+        docs->capacity = capacity;
+    }
+
+    // Keep the name index at most half full
+    if (2 * (docs->count + 1) > docs->slotCount && grow_slots(docs) == FAILURE)
+        return FAILURE;
+
+    strcpy(docs->names[docs->count], filename);
+    docs->sizes[docs->count] = DOC_UNKNOWN;
+    docs->mtimes[docs->count] = DOC_UNKNOWN_TIME;
+    docs->tokenCounts[docs->count] = DOC_UNKNOWN;
+    minhash_init(docs->signatures[docs->count]);
+    docs->slots[find_slot(docs, filename)] = docs->count + 1;
+    return docs->count++;
+}
+
+/**
+ * Stores the metadata columns of one document.
+ */
+void docTable_set_metadata(DocTable *docs, int docId, long long size, long long mtime, int tokenCount)
+{
+    docs->sizes[docId] = size;
+    docs->mtimes[docId] = mtime;
+    docs->tokenCounts[docId] = tokenCount;
+}
+
+/**
+ * Stores the signature column of one document. Files without a single
+ * word are not filed in the LSH index: they are similar to nothing.
+ */
+int docTable_set_signature(DocTable *docs, int docId, const unsigned int signature[MINHASH_SIZE])
+{
+    memcpy(docs->signatures[docId], signature, sizeof(docs->signatures[docId]));
+    if (minhash_is_empty(signature))
+        return SUCCESS;
+    return lsh_insert(&docs->lsh, docId, signature);
+}
+
+/**
+ * Compares signature with the LSH candidates only.
+ */
+int docTable_find_near_duplicate(DocTable *docs, const unsigned int signature[MINHASH_SIZE], int exclude, double threshold, double *similarity)
+{
+    int *ids;
+    int count = lsh_candidates(&docs->lsh, signature, &ids);
+    if (count == FAILURE)
+        return FAILURE;
+    int best = FAILURE;
+    double bestSimilarity = threshold;
+    for (int i = 0; i < count; i++)
+    {
+        if (ids[i] == exclude)
+            continue;
+        double estimate = minhash_similarity(signature, docs->signatures[ids[i]]);
+        if (estimate >= bestSimilarity && (best == FAILURE || estimate > bestSimilarity))
+        {
+            best = ids[i];
+            bestSimilarity = estimate;
+        }
+    }
+    free(ids);
+    if (best != FAILURE)
+        *similarity = bestSimilarity;
+    return best;
+}
+
+/**
+ * Copies the names, the name index, the metadata columns and the
+ * signatures.
+ */
+int docTable_clone(DocTable *dst, DocTable *src)
+{
+    initialize_docTable(dst);
+    if (src->count == 0)
+        return SUCCESS;
+
+    dst->names = malloc(src->capacity * sizeof(*src->names));
+    dst->slots = malloc(src->slotCount * sizeof(int));
+    dst->sizes = malloc(src->capacity * sizeof(long long));
+    dst->mtimes = malloc(src->capacity * sizeof(long long));
+    dst->tokenCounts = malloc(src->capacity * sizeof(int));
+    dst->signatures = malloc(src->capacity * sizeof(*src->signatures));
+    if (dst->names == NULL || dst->slots == NULL || dst->sizes == NULL || dst->mtimes == NULL || dst->tokenCounts == NULL ||
+        dst->signatures == NULL || lsh_clone(&dst->lsh, &src->lsh) == FAILURE)
+    {
+        free_docTable(dst);
+        return FAILURE;
+    }
+    memcpy(dst->names, src->names, src->count * sizeof(*src->names));
+    memcpy(dst->slots, src->slots, src->slotCount * sizeof(int));
+    memcpy(dst->sizes, src->sizes, src->count * sizeof(long long));
+    memcpy(dst->mtimes, src->mtimes, src->count * sizeof(long long));
+    memcpy(dst->tokenCounts, src->tokenCounts, src->count * sizeof(int));
+    memcpy(dst->signatures, src->signatures, src->count * sizeof(*src->signatures));
+    dst->count = src->count;
+    dst->capacity = src->capacity;
+    dst->slotCount = src->slotCount;
+    return SUCCESS;
+}
+
+/**
+ * Releases the names, the name index, the metadata columns and the
+ * signatures.
+ */
+void free_docTable(DocTable *docs)
+{
+    free(docs->names);
+    free(docs->slots);
+    free(docs->sizes);
+    free(docs->mtimes);
+    free(docs->tokenCounts);
+    free(docs->signatures);
+    lsh_free(&docs->lsh);
+    initialize_docTable(docs);
+}
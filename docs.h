@@ -0,0 +1,101 @@
+/***********************************************************************
+ *  File name   : docs.h
+ *  Description : Header file for the document table of the Inverted
+ *                Search Project.
+ *                Every indexed file gets a small integer document id,
+ *                so posting lists can be handled as sorted id arrays.
+ *                Names are found through a small open-addressing
+ *                index, so loading a backup resolves ids in O(1).
+ *                File metadata (size, modification time, token count)
+ *                is kept in one array per field, indexed by document
+ *                id, so filters scan contiguous values.
+ *                The MinHash signature of every indexed file is kept
+ *                the same way, with an LSH index over the signatures
+ *                to look up near-duplicate files.
+ *
+ *                Functions:
+ *                - initialize_docTable()
+ *                - docTable_get_id()
+ *                - docTable_find_id()
+ *                - docTable_set_metadata()
+ *                - docTable_set_signature()
+ *                - docTable_find_near_duplicate()
+ *                - docTable_clone()
+ *                - free_docTable()
+ *
+ ***********************************************************************/
+
+#ifndef DOCS_H
+#define DOCS_H
+
+#include <limits.h>
+
+#include "list.h"
+#include "minhash.h"
+
+#define DOC_UNKNOWN -1                   // Metadata value of files loaded from a backup
+#define DOC_UNKNOWN_TIME LLONG_MIN       // Same for mtimes, where -1 is a valid time
+
+/* DocTable:
+ * Dense table of indexed files, addressed by document id.
+ */
+typedef struct DocTable
+{
+    char (*names)[MAX_FILENAME_LENGTH];  // File name of each document id
+    int count;                           // Number of documents
+    int capacity;                        // Allocated entries
+    int *slots;                          // Name index: document id + 1, 0 if free
+    int slotCount;                       // Size of slots (power of two)
+    long long *sizes;                    // File size in bytes
+    long long *mtimes;                   // Last modification time (seconds since epoch, may be negative)
+    int *tokenCounts;                    // Words read from the file
+    unsigned int (*signatures)[MINHASH_SIZE]; // MinHash of the file, empty if unknown
+    LshIndex lsh;                        // Band buckets of the non-empty signatures
+} DocTable;
+
+/**
+ * Initializes an empty document table.
+ */
+void initialize_docTable(DocTable *docs);
+
+/**
+ * Returns the document id of filename, registering it if needed.
+ * Returns FAILURE if the table could not grow.
+ */
+int docTable_get_id(DocTable *docs, char *filename);
+
+/**
+ * Returns the document id of filename, or FAILURE if it is unknown.
+ */
+int docTable_find_id(DocTable *docs, char *filename);
+
+/**
+ * Records the metadata of a document captured while indexing it.
+ */
+void docTable_set_metadata(DocTable *docs, int docId, long long size, long long mtime, int tokenCount);
+
+/**
+ * Records the MinHash signature of a document and files it in the LSH
+ * index. Returns SUCCESS or FAILURE.
+ */
+int docTable_set_signature(DocTable *docs, int docId, const unsigned int signature[MINHASH_SIZE]);
+
+/**
+ * Returns the id of the indexed file most similar to signature, other
+ * than exclude, if its estimated similarity is at least threshold
+ * (stored in *similarity). Returns FAILURE if there is none.
+ */
+int docTable_find_near_duplicate(DocTable *docs, const unsigned int signature[MINHASH_SIZE], int exclude, double threshold, double *similarity);
+
+/**
+ * Stores a copy of src in dst (initialized by the call).
+ * Returns SUCCESS or FAILURE.
+ */
+int docTable_clone(DocTable *dst, DocTable *src);
+
+/**
+ * Releases the memory of the table and empties it.
+ */
+void free_docTable(DocTable *docs);
+
+#endif
@@ -0,0 +1,257 @@
+/***********************************************************************
+ *  File name   : export.c
+ *  Description : Implementation file for the streaming export of the
+ *                Inverted Search Project.
+ *
+ *                Functions:
+ *                - exportOptions_init()
+ *                - exportOptions_parse()
+ *                - export_database()
+ *
+ ***********************************************************************/
+
+#include <limits.h>
+
+#include "export.h"
+#include "buffer.h"
+#include "parallel.h"
+
+void exportOptions_init(ExportOptions *options)
+{
+    options->format = EXPORT_TSV;
+    options->from[0] = '\0';
+    options->to[0] = '\0';
+    options->offset = 0;
+    options->limit = -1;
+    options->page = 0;
+}
+
+/**
+ * Parses a non-negative number. Returns SUCCESS or FAILURE.
+ */
+static int parse_number(char *text, long *value)
+{
+    char *end;
+    *value = strtol(text, &end, 10);
+    return (end == text || *end != '\0' || *value < 0) ? FAILURE : SUCCESS;
+}
+
+/**
+ * Parses key=value options.
+ */
+int exportOptions_parse(ExportOptions *options, char *text)
+{
+    for (char *option = strtok(text, " \t"); option; option = strtok(NULL, " \t"))
+    {
+        if (strcmp(option, "-") == 0)
+            continue;
+        char *value = strchr(option, '=');
+        int valid = value != NULL;
+        if (valid)
+        {
+            *value++ = '\0';
+            if ((strcmp(option, "from") == 0 || strcmp(option, "to") == 0) && strlen(value) < MAX_WORD_LENGTH)
+                strcpy(strcmp(option, "from") == 0 ? options->from : options->to, value);
+            else if (strcmp(option, "offset") == 0)
+                valid = parse_number(value, &options->offset) == SUCCESS;
+            else if (strcmp(option, "limit") == 0)
+                valid = parse_number(value, &options->limit) == SUCCESS && options->limit > 0;
+            else if (strcmp(option, "page") == 0)
+                valid = parse_number(value, &options->page) == SUCCESS && options->page > 0;
+            else
+                valid = 0;
+            value[-1] = '=';
+        }
+        if (!valid)
+        {
+            fprintf(stderr, "\nERROR: Invalid export option '%s'\n", option);
+            return FAILURE;
+        }
+    }
+    if (options->page && options->limit < 0)
+    {
+        fprintf(stderr, "\nERROR: page needs a limit (the page size)\n");
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/* ExportJob:
+ * One window of sorted words, formatted by chunks of EXPORT_CHUNK_TERMS.
+ */
+typedef struct ExportJob
+{
+    MainNode **terms;
+    int first;                 // First word of the window
+    int end;                   // End of the window
+    DocTable *docs;
+    int format;
+    TextBuffer *buffers;       // Output of each chunk
+} ExportJob;
+
+/* Appends text as a JSON string (with quotes) */
+static void append_json_str(TextBuffer *out, const char *text)
+{
+    buffer_append(out, "\"", 1);
+    for (const char *p = text; *p; p++)
+    {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\')
+        {
+            char escaped[2] = { '\\', (char)c };
+            buffer_append(out, escaped, 2);
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            int length = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            buffer_append(out, escaped, length);
+        }
+        else
+            buffer_append(out, p, 1);
+    }
+    buffer_append(out, "\"", 1);
+}
+
+/* Formats one chunk of words */
+static int export_chunk(int chunk, void *arg)
+{
+    ExportJob *job = arg;
+    TextBuffer *out = &job->buffers[chunk];
+    int first = job->first + chunk * EXPORT_CHUNK_TERMS;
+    int last = first + EXPORT_CHUNK_TERMS < job->end ? first + EXPORT_CHUNK_TERMS : job->end;
+    for (int t = first; t < last; t++)
+    {
+        MainNode *node = job->terms[t];
+        PostingCursor cursor;
+        int docId, wordCount, files = 0;
+        postingCursor_init(&cursor, node);
+        if (job->format == EXPORT_JSONL)
+        {
+            buffer_append_str(out, "{\"word\":");
+            append_json_str(out, node->word);
+            buffer_append_str(out, ",\"files\":[");
+        }
+        while (postingCursor_next(&cursor, &docId, &wordCount))
+        {
+            if (job->format == EXPORT_TSV)
+            {
+                buffer_append_str(out, node->word);
+                buffer_append(out, "\t", 1);
+                buffer_append_str(out, job->docs->names[docId]);
+                buffer_append(out, "\t", 1);
+                buffer_append_int(out, wordCount);
+                buffer_append(out, "\n", 1);
+            }
+            else
+            {
+                buffer_append_str(out, files ? ",{\"file\":" : "{\"file\":");
+                append_json_str(out, job->docs->names[docId]);
+                buffer_append_str(out, ",\"count\":");
+                buffer_append_int(out, wordCount);
+                buffer_append(out, "}", 1);
+            }
+            files++;
+        }
+        if (job->format == EXPORT_JSONL)
+        {
+            buffer_append_str(out, "],\"fileCount\":");
+            buffer_append_int(out, files);
+            buffer_append_str(out, "}\n");
+        }
+    }
+    return out->failed ? FAILURE : SUCCESS;
+}
+
+/**
+ * Words of the range to skip: the offset plus the pages before the
+ * requested one, saturated at LONG_MAX (past any range).
+ */
+static long skipped_words(ExportOptions *options)
+{
+    long pages = options->page ? options->page - 1 : 0;
+    if (pages > 0 && pages > (LONG_MAX - options->offset) / options->limit)
+        return LONG_MAX;
+    return options->offset + pages * options->limit;
+}
+
+/**
+ * Selects the sorted words of the range up to the end of the page (and
+ * the first word of the next one), then formats and writes one window
+ * of chunks at a time.
+ */
+int export_database(HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, ExportOptions *options, char *path)
+{
+    long skip = skipped_words(options);
+    long wanted = -1;
+    if (options->limit >= 0)
+        wanted = skip < LONG_MAX - options->limit ? skip + options->limit + 1 : LONG_MAX;
+
+    MainNode **terms;
+    int rangeCount;
+    int stored = hashTable_sorted_terms(hashTablle, options->from, options->to, wanted, &terms, &rangeCount);
+    if (stored == FAILURE)
+        return FAILURE;
+
+    // Offset and page inside the range
+    int start = skip < stored ? (int)skip : stored;
+    int end = options->limit >= 0 && options->limit < stored - start ? start + (int)options->limit : stored;
+
+    FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "\nERROR: Export FILE %s could not be created\n", path);
+        free(terms);
+        return FAILURE;
+    }
+    fflush(stdout);
+
+    int status = SUCCESS;
+    if (options->format == EXPORT_TSV && fputs("word\tfile\tcount\n", fp) == EOF)
+        status = FAILURE;
+
+    int threads = get_thread_count();
+    int windowTerms = threads * EXPORT_CHUNK_TERMS;
+    ExportJob job;
+    job.terms = terms;
+    job.docs = docs;
+    job.format = options->format;
+    job.buffers = malloc(threads * sizeof(TextBuffer));
+    if (job.buffers == NULL)
+        status = FAILURE;
+    for (int first = start; first < end && status == SUCCESS; first += windowTerms)
+    {
+        job.first = first;
+        job.end = end - first < windowTerms ? end : first + windowTerms;
+        int chunks = (job.end - first + EXPORT_CHUNK_TERMS - 1) / EXPORT_CHUNK_TERMS;
+        for (int c = 0; c < chunks; c++)
+            buffer_init(&job.buffers[c]);
+        status = parallel_for(chunks, threads, export_chunk, &job);
+        for (int c = 0; c < chunks; c++)
+        {
+            TextBuffer *buffer = &job.buffers[c];
+            if (status == SUCCESS && buffer->length && fwrite(buffer->data, 1, buffer->length, fp) != buffer->length)
+                status = FAILURE;
+            buffer_free(buffer);
+        }
+    }
+    free(job.buffers);
+
+    if ((fp == stdout ? fflush(fp) : fclose(fp)) != 0 || status == FAILURE)
+    {
+        fprintf(stderr, "\nERROR: Could not write export to %s\n", path);
+        free(terms);
+        return FAILURE;
+    }
+    fprintf(stderr, "\nINFO: Exported %d of %d word(s) in range to %s\n", end - start, rangeCount, path);
+    // Cursor of the next page: its first word, selected with the page
+    if (end < stored)
+    {
+        fprintf(stderr, "INFO: Next page: from=%s", terms[end]->word);
+        if (options->to[0])
+            fprintf(stderr, " to=%s", options->to);
+        fprintf(stderr, " limit=%ld\n", options->limit);
+    }
+    free(terms);
+    return SUCCESS;
+}
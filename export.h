@@ -0,0 +1,68 @@
+/***********************************************************************
+ *  File name   : export.h
+ *  Description : Header file for the streaming export of the Inverted
+ *                Search Project.
+ *                Words are exported in alphabetical order, optionally
+ *                restricted to a word range and a page of it, as
+ *                TSV (one "word, file, count" row per posting) or
+ *                JSONL (one object per word). Windows of words are
+ *                formatted in parallel into memory buffers and written
+ *                with large fwrite calls, so memory stays bounded and
+ *                the output does not depend on the number of threads.
+ *
+ *                Options (space separated, "-" for none):
+ *                  from=<word>   first word (inclusive)
+ *                  to=<word>     end of the range (exclusive)
+ *                  offset=<n>    words of the range to skip
+ *                  limit=<n>     words to export (page size)
+ *                  page=<n>      1-based page of limit words (empty past
+ *                                the end of the range)
+ *
+ *                Functions:
+ *                - exportOptions_init()
+ *                - exportOptions_parse()
+ *                - export_database()
+ *
+ ***********************************************************************/
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "list.h"
+#include "docs.h"
+
+#define EXPORT_TSV 1
+#define EXPORT_JSONL 2
+#define EXPORT_CHUNK_TERMS 4096          // Words formatted by one work item
+
+/* ExportOptions:
+ * Format, word range and page of an export.
+ */
+typedef struct ExportOptions
+{
+    int format;                          // EXPORT_TSV or EXPORT_JSONL
+    char from[MAX_WORD_LENGTH];          // "" for the first word
+    char to[MAX_WORD_LENGTH];            // "" for past the last word
+    long offset;
+    long limit;                          // -1 for no limit
+    long page;                           // 0 if not given
+} ExportOptions;
+
+/**
+ * Initializes options exporting every word as TSV.
+ */
+void exportOptions_init(ExportOptions *options);
+
+/**
+ * Adds the options of text. Returns SUCCESS, or FAILURE (with a
+ * message) if an option cannot be parsed.
+ */
+int exportOptions_parse(ExportOptions *options, char *text);
+
+/**
+ * Writes the selected words to path ("-" for standard output).
+ * Returns SUCCESS or FAILURE.
+ */
+int export_database(HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, ExportOptions *options, char *path);
+
+#endif
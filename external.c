@@ -0,0 +1,594 @@
+/***********************************************************************
+ *  File name   : external.c
+ *  Description : Implementation file for the low-memory (external sort)
+ *                build of the Inverted Search Project.
+ *                1. Every word read becomes a (word, file, 1) tuple.
+ *                2. When the tuple buffer reaches the memory budget it
+ *                   is sorted by (index, word, file), equal tuples are
+ *                   summed, and the result is spilled as a run at the
+ *                   end of a temporary file.
+ *                3. Runs are merged with a k-way heap merge, at most
+ *                   as many at a time as the budget can give a read
+ *                   block; while there are more, groups of runs are
+ *                   merged into longer runs of a new temporary file.
+ *                4. The last merge writes every word as one DATABASE
+ *                   line.
+ *                Memory use is bounded by the budget, and two files are
+ *                open for runs, whatever the size of the input.
+ *
+ *                Functions:
+ *                - create_database_external()
+ *
+ ***********************************************************************/
+
+#define _FILE_OFFSET_BITS 64            // 64-bit off_t for runs over 2 GiB
+
+#include <sys/types.h>
+
+#include "external.h"
+#include "validate.h"
+#include "docs.h"
+#include "buffer.h"
+
+#define OUTPUT_FLUSH_SIZE (1 << 20)     // Bytes of DATABASE lines written per fwrite
+#define MIN_RUN_BLOCK 64                // Smallest number of tuples read per run refill
+
+#ifndef EXTERNAL_MAX_FAN_IN
+#define EXTERNAL_MAX_FAN_IN 1024        // Most runs merged at a time, whatever the budget
+#endif
+
+/* TermTuple:
+ * One word occurring wordCount times in file docId.
+ */
+typedef struct TermTuple
+{
+    char word[MAX_WORD_LENGTH];
+    int index;                 // Hash table index of the word
+    int docId;                 // Position of the file in the DocTable
+    int wordCount;
+} TermTuple;
+
+/* RunFile:
+ * Sorted runs stored one after another in a temporary file.
+ */
+typedef struct RunFile
+{
+    FILE *fp;                  // Temporary file, deleted when closed
+    long long *starts;         // First tuple of each run, then of the one being written
+    long long end;             // Tuples written
+    int count;                 // Number of runs
+    int capacity;              // Allocated runs
+} RunFile;
+
+/* RunReader:
+ * Buffered reader of one run of a RunFile.
+ */
+typedef struct RunReader
+{
+    FILE *fp;
+    long long next;            // Next tuple of the run to read
+    long long end;             // End of the run
+    TermTuple *block;          // Tuples read from the run
+    int count;                 // Tuples in block
+    int pos;                   // Next tuple of block
+} RunReader;
+
+/* Merger:
+ * Min-heap of readers over a group of runs.
+ */
+typedef struct Merger
+{
+    RunReader *readers;
+    int *heap;                 // Readers with tuples left, smallest head first
+    int size;
+    int k;
+    int blockSize;
+} Merger;
+
+/* ExternalBuild:
+ * Tuple buffer and the runs spilled so far.
+ */
+typedef struct ExternalBuild
+{
+    TermTuple *tuples;
+    long count;
+    long capacity;             // Tuples fitting in the memory budget
+    RunFile runs;
+} ExternalBuild;
+
+/* Orders tuples by index, word and document id */
+static int compare_tuple(const void *a, const void *b)
+{
+    const TermTuple *x = a, *y = b;
+    if (x->index != y->index)
+        return x->index - y->index;
+    int cmp = strcmp(x->word, y->word);
+    if (cmp != 0)
+        return cmp;
+    return (x->docId > y->docId) - (x->docId < y->docId);
+}
+
+/**
+ * Opens an empty run file. Returns SUCCESS or FAILURE.
+ */
+static int runFile_open(RunFile *runs)
+{
+    runs->count = 0;
+    runs->end = 0;
+    runs->capacity = 8;
+    runs->starts = calloc(runs->capacity + 1, sizeof(long long));
+    runs->fp = runs->starts ? tmpfile() : NULL;
+    if (runs->fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not create a temporary run file\n");
+        free(runs->starts);
+        runs->starts = NULL;
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+static void runFile_close(RunFile *runs)
+{
+    if (runs->fp)
+        fclose(runs->fp);
+    free(runs->starts);
+    runs->fp = NULL;
+    runs->starts = NULL;
+    runs->count = 0;
+}
+
+/**
+ * Adds count tuples to the run being written (the one after the last
+ * ended run). Returns SUCCESS or FAILURE.
+ */
+static int runFile_append(RunFile *runs, TermTuple *tuples, long count)
+{
+    if (count == 0)
+        return SUCCESS;
+    if (fseeko(runs->fp, (off_t)(runs->end * (long long)sizeof(TermTuple)), SEEK_SET) != 0 ||
+        fwrite(tuples, sizeof(TermTuple), count, runs->fp) != (size_t)count)
+    {
+        fprintf(stderr, "ERROR: Could not write a temporary run file\n");
+        return FAILURE;
+    }
+    runs->end += count;
+    return SUCCESS;
+}
+
+/**
+ * Ends the run being written. Returns SUCCESS or FAILURE.
+ */
+static int runFile_end_run(RunFile *runs)
+{
+    if (runs->count == runs->capacity)
+    {
+        long long *starts = realloc(runs->starts, (2 * runs->capacity + 1) * sizeof(long long));
+        if (starts == NULL)
+            return FAILURE;
+        runs->starts = starts;
+        runs->capacity *= 2;
+    }
+    runs->starts[++runs->count] = runs->end;
+    return SUCCESS;
+}
+
+/**
+ * Sorts the tuple buffer, sums equal (word, file) tuples and writes
+ * them as a new run of the spill file.
+ */
+static int spill_run(ExternalBuild *build)
+{
+    if (build->count == 0)
+        return SUCCESS;
+
+    qsort(build->tuples, build->count, sizeof(TermTuple), compare_tuple);
+    long unique = 0;
+    for (long i = 0; i < build->count; i++)
+    {
+        if (unique > 0 && compare_tuple(&build->tuples[unique - 1], &build->tuples[i]) == 0)
+            build->tuples[unique - 1].wordCount += build->tuples[i].wordCount;
+        else
+            build->tuples[unique++] = build->tuples[i];
+    }
+
+    if (runFile_append(&build->runs, build->tuples, unique) == FAILURE || runFile_end_run(&build->runs) == FAILURE)
+        return FAILURE;
+    build->count = 0;
+    return SUCCESS;
+}
+
+/**
+ * Reads every file of the list into tuples, spilling runs as needed.
+ */
+static int collect_runs(FileList *filelist, DocTable *docs, ExternalBuild *build)
+{
+    for (FileList *temp = filelist; temp; temp = temp->link)
+    {
+        FILE *fp = fopen(temp->filename, "r");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "Error: Could not open file '%s'\n", temp->filename);
+            continue;
+        }
+        int docId = docTable_get_id(docs, temp->filename);
+        if (docId == FAILURE)
+        {
+            fclose(fp);
+            return FAILURE;
+        }
+
+        char word[MAX_WORD_LENGTH];
+        while (fscanf(fp, "%19s", word) == 1)
+        {
+            int index = get_word_index(word);
+            if (index < 0 || index >= MAX_HASH_SIZE)
+            {
+                fprintf(stderr, "INFO: Skipping word '%s' (index %d out of range)\n", word, index);
+                continue;
+            }
+            if (build->count == build->capacity && spill_run(build) == FAILURE)
+            {
+                fclose(fp);
+                return FAILURE;
+            }
+            TermTuple *tuple = &build->tuples[build->count++];
+            strcpy(tuple->word, word);
+            tuple->index = index;
+            tuple->docId = docId;
+            tuple->wordCount = 1;
+        }
+        fclose(fp);
+        printf("\nINFO: Words of file %s collected (%d run(s) spilled so far)\n", temp->filename, build->runs.count);
+    }
+    return spill_run(build);
+}
+
+/**
+ * Refills a reader from its run. Returns 0 once the run is exhausted.
+ */
+static int reader_fill(RunReader *reader, int blockSize)
+{
+    if (reader->pos < reader->count)
+        return 1;
+    long long left = reader->end - reader->next;
+    int want = left < blockSize ? (int)left : blockSize;
+    reader->count = 0;
+    reader->pos = 0;
+    // Readers of one pass share the run file, each one seeks to its run
+    if (want == 0 || fseeko(reader->fp, (off_t)(reader->next * (long long)sizeof(TermTuple)), SEEK_SET) != 0)
+        return 0;
+    reader->count = (int)fread(reader->block, sizeof(TermTuple), want, reader->fp);
+    reader->next += reader->count;
+    return reader->count > 0;
+}
+
+static TermTuple *reader_head(RunReader *reader)
+{
+    return &reader->block[reader->pos];
+}
+
+/**
+ * Restores the min-heap property from position i downwards.
+ */
+static void heap_sift_down(int *heap, int size, int i, RunReader *readers)
+{
+    while (1)
+    {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && compare_tuple(reader_head(&readers[heap[left]]), reader_head(&readers[heap[smallest]])) < 0)
+            smallest = left;
+        if (right < size && compare_tuple(reader_head(&readers[heap[right]]), reader_head(&readers[heap[smallest]])) < 0)
+            smallest = right;
+        if (smallest == i)
+            return;
+        int t = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = t;
+        i = smallest;
+    }
+}
+
+/**
+ * Opens readers on runs [first, first + k) of a run file and heapifies
+ * them. Returns SUCCESS or FAILURE.
+ */
+static int merger_open(Merger *merger, RunFile *runs, int first, int k, int blockSize)
+{
+    merger->blockSize = blockSize;
+    merger->k = k;
+    merger->size = 0;
+    merger->readers = calloc(k ? k : 1, sizeof(RunReader));
+    merger->heap = malloc((k ? k : 1) * sizeof(int));
+    if (merger->readers == NULL || merger->heap == NULL)
+        return FAILURE;
+
+    for (int r = 0; r < k; r++)
+    {
+        RunReader *reader = &merger->readers[r];
+        reader->fp = runs->fp;
+        reader->next = runs->starts[first + r];
+        reader->end = runs->starts[first + r + 1];
+        reader->block = malloc(blockSize * sizeof(TermTuple));
+        if (reader->block == NULL)
+            return FAILURE;
+        if (reader_fill(reader, blockSize))
+            merger->heap[merger->size++] = r;
+    }
+    for (int i = merger->size / 2 - 1; i >= 0; i--)
+        heap_sift_down(merger->heap, merger->size, i, merger->readers);
+    return SUCCESS;
+}
+
+/**
+ * Takes the smallest tuple of the merged runs. Returns 0 once all of
+ * them are exhausted.
+ */
+static int merger_next(Merger *merger, TermTuple *tuple)
+{
+    if (merger->size == 0)
+        return 0;
+    RunReader *reader = &merger->readers[merger->heap[0]];
+    *tuple = *reader_head(reader);
+    reader->pos++;
+    if (!reader_fill(reader, merger->blockSize))
+        merger->heap[0] = merger->heap[--merger->size];
+    heap_sift_down(merger->heap, merger->size, 0, merger->readers);
+    return 1;
+}
+
+static void merger_close(Merger *merger)
+{
+    for (int r = 0; merger->readers && r < merger->k; r++)
+        free(merger->readers[r].block);
+    free(merger->readers);
+    free(merger->heap);
+}
+
+/**
+ * Number of tuples read per run refill when k runs are merged, one more
+ * block of the budget being kept for the output.
+ */
+static int merge_block_size(long budgetBytes, int k)
+{
+    return (int)(budgetBytes / ((long)(k + 1) * sizeof(TermTuple)));
+}
+
+/**
+ * Most runs that one merge can read at a time: each one needs a block
+ * of at least MIN_RUN_BLOCK tuples within the budget.
+ */
+static int merge_fan_in(long budgetBytes)
+{
+    long fanIn = budgetBytes / ((long)MIN_RUN_BLOCK * sizeof(TermTuple)) - 1;
+    if (fanIn > EXTERNAL_MAX_FAN_IN)
+        fanIn = EXTERNAL_MAX_FAN_IN;
+    return fanIn < 2 ? 2 : (int)fanIn;
+}
+
+/**
+ * Merges runs [first, first + k) of in into one new run of out, summing
+ * the tuples of a file that spans several runs.
+ */
+static int merge_group(RunFile *in, int first, int k, RunFile *out, long budgetBytes)
+{
+    int blockSize = merge_block_size(budgetBytes, k);
+    Merger merger;
+    TermTuple *block = malloc(blockSize * sizeof(TermTuple));
+    int status = merger_open(&merger, in, first, k, blockSize);
+    if (block == NULL)
+        status = FAILURE;
+
+    int count = 0;
+    TermTuple next;
+    while (status == SUCCESS && merger_next(&merger, &next))
+    {
+        if (count > 0 && compare_tuple(&block[count - 1], &next) == 0)
+        {
+            block[count - 1].wordCount += next.wordCount;
+            continue;
+        }
+        // The last tuple is held back, the next one may still add to it
+        if (count == blockSize)
+        {
+            status = runFile_append(out, block, count - 1);
+            block[0] = block[count - 1];
+            count = 1;
+        }
+        block[count++] = next;
+    }
+    if (status == SUCCESS)
+        status = runFile_append(out, block, count);
+    if (status == SUCCESS)
+        status = runFile_end_run(out);
+
+    merger_close(&merger);
+    free(block);
+    return status;
+}
+
+/**
+ * Merges groups of fanIn runs into longer runs until one merge can read
+ * them all. Returns the number of passes made, or FAILURE.
+ */
+static int reduce_runs(RunFile *runs, long budgetBytes)
+{
+    int fanIn = merge_fan_in(budgetBytes);
+    int passes = 0;
+    while (runs->count > fanIn)
+    {
+        RunFile next;
+        if (runFile_open(&next) == FAILURE)
+            return FAILURE;
+        for (int first = 0; first < runs->count; first += fanIn)
+        {
+            int k = runs->count - first < fanIn ? runs->count - first : fanIn;
+            if (merge_group(runs, first, k, &next, budgetBytes) == FAILURE)
+            {
+                runFile_close(&next);
+                return FAILURE;
+            }
+        }
+        runFile_close(runs);
+        *runs = next;
+        passes++;
+    }
+    return passes;
+}
+
+/**
+ * Appends one DATABASE line for a word and its postings.
+ */
+static void append_line(TextBuffer *out, TermTuple *word, DocTable *docs, int *docIds, int *wordCounts, int files)
+{
+    buffer_append_str(out, "#");
+    buffer_append_int(out, word->index);
+    buffer_append_str(out, ";");
+    buffer_append_str(out, word->word);
+    buffer_append_str(out, ";");
+    buffer_append_int(out, files);
+    buffer_append_str(out, ";");
+    for (int i = 0; i < files; i++)
+    {
+        buffer_append_str(out, docs->names[docIds[i]]);
+        buffer_append_str(out, ";");
+        buffer_append_int(out, wordCounts[i]);
+        buffer_append_str(out, ";");
+    }
+    buffer_append_str(out, "#\n");
+}
+
+/**
+ * Writes the buffered lines once they pass threshold bytes.
+ */
+static int flush_output(TextBuffer *out, FILE *fp, size_t threshold)
+{
+    if (out->failed)
+        return FAILURE;
+    if (out->length < threshold || out->length == 0)
+        return SUCCESS;
+    if (fwrite(out->data, 1, out->length, fp) != out->length)
+        return FAILURE;
+    out->length = 0;
+    return SUCCESS;
+}
+
+/**
+ * k-way merge of the runs into the DATABASE file. Tuples of one word
+ * come out together, ordered by document id; a file that spans
+ * several runs has its counts summed.
+ */
+static int merge_runs(RunFile *runs, DocTable *docs, FILE *fp, long budgetBytes)
+{
+    Merger merger;
+    int *docIds = malloc((docs->count + 1) * sizeof(int));
+    int *wordCounts = malloc((docs->count + 1) * sizeof(int));
+    int status = (docIds && wordCounts) ? SUCCESS : FAILURE;
+    if (merger_open(&merger, runs, 0, runs->count, merge_block_size(budgetBytes, runs->count)) == FAILURE)
+        status = FAILURE;
+
+    TextBuffer out;
+    buffer_init(&out);
+    TermTuple current, next;
+    int files = 0;
+    while (status == SUCCESS && merger_next(&merger, &next))
+    {
+        int sameWord = files > 0 && next.index == current.index && strcmp(next.word, current.word) == 0;
+        if (!sameWord)
+        {
+            if (files > 0)
+                append_line(&out, &current, docs, docIds, wordCounts, files);
+            current = next;
+            files = 0;
+        }
+        if (files > 0 && docIds[files - 1] == next.docId)
+            wordCounts[files - 1] += next.wordCount;
+        else
+        {
+            docIds[files] = next.docId;
+            wordCounts[files++] = next.wordCount;
+        }
+        status = flush_output(&out, fp, OUTPUT_FLUSH_SIZE);
+    }
+    if (files > 0 && status == SUCCESS)
+        append_line(&out, &current, docs, docIds, wordCounts, files);
+    if (status == SUCCESS)
+        status = flush_output(&out, fp, 0);
+
+    buffer_free(&out);
+    merger_close(&merger);
+    free(docIds);
+    free(wordCounts);
+    return status;
+}
+
+/**
+ * Builds the DATABASE backup file of filelist with bounded memory.
+ */
+int create_database_external(FileList *filelist, char *backup, int budgetMB)
+{
+    if (filelist == NULL)
+    {
+        fprintf(stderr, "\nINFO: File List is Empty\n");
+        return FAILURE;
+    }
+    if (valid_file_name(backup) == FAILURE)
+    {
+        fprintf(stderr, "ERROR: Invalid File name\n");
+        return FAILURE;
+    }
+    if (budgetMB < MIN_MEMORY_BUDGET_MB)
+        budgetMB = MIN_MEMORY_BUDGET_MB;
+
+    long budgetBytes = (long)budgetMB * 1024 * 1024;
+    ExternalBuild build;
+    // Half of the budget holds tuples, qsort may use the other half as scratch space
+    build.capacity = budgetBytes / (2 * (long)sizeof(TermTuple));
+    build.count = 0;
+    build.tuples = malloc(build.capacity * sizeof(TermTuple));
+    if (build.tuples == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not allocate %d MB for the tuple buffer\n", budgetMB);
+        return FAILURE;
+    }
+    if (runFile_open(&build.runs) == FAILURE)
+    {
+        free(build.tuples);
+        return FAILURE;
+    }
+
+    DocTable docs;
+    initialize_docTable(&docs);
+    int status = collect_runs(filelist, &docs, &build);
+
+    // The tuple buffer is released before merging, the run readers reuse the budget
+    free(build.tuples);
+    int spilled = build.runs.count;
+    int passes = 0;
+    if (status == SUCCESS && (passes = reduce_runs(&build.runs, budgetBytes)) == FAILURE)
+        status = FAILURE;
+    FILE *fp = NULL;
+    if (status == SUCCESS && (fp = fopen(backup, "w")) == NULL)
+    {
+        fprintf(stderr, "Backup FILE with name %s Could not be created\n", backup);
+        status = FAILURE;
+    }
+    if (status == SUCCESS)
+    {
+        fprintf(fp, "#%s;%s;%s;%s;%s;#\n", "Index", "Word", "FileCount", "FileName", "wordCount");
+        status = merge_runs(&build.runs, &docs, fp, budgetBytes);
+        if (fclose(fp) != 0)
+            status = FAILURE;
+    }
+
+    runFile_close(&build.runs);
+    free_docTable(&docs);
+
+    if (status == FAILURE)
+    {
+        fprintf(stderr, "ERROR: Low memory build of %s failed\n", backup);
+        return FAILURE;
+    }
+    printf("\nINFO: Database written to %s using %d run(s) in %d merge pass(es)\n", backup, spilled, passes + 1);
+    return SUCCESS;
+}
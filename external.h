@@ -0,0 +1,32 @@
+/***********************************************************************
+ *  File name   : external.h
+ *  Description : Header file for the low-memory (external sort) build
+ *                of the Inverted Search Project.
+ *                Instead of building the hash table in RAM, words are
+ *                collected as (word, file, count) tuples up to a memory
+ *                budget, sorted and spilled as runs of a temporary
+ *                file, and the runs are merged (in several passes when
+ *                the budget cannot read them all at once) into a
+ *                DATABASE backup file that can be loaded with
+ *                update_database().
+ *
+ *                Functions:
+ *                - create_database_external()
+ *
+ ***********************************************************************/
+
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include "list.h"
+
+#define DEFAULT_MEMORY_BUDGET_MB 64     // Tuple memory used when no budget is given
+#define MIN_MEMORY_BUDGET_MB 1          // Smallest accepted budget
+
+/**
+ * Indexes every file of filelist into the backup file using at most
+ * budgetMB megabytes for tuples. Returns SUCCESS or FAILURE.
+ */
+int create_database_external(FileList *filelist, char *backup, int budgetMB);
+
+#endif
@@ -0,0 +1,261 @@
+/***********************************************************************
+ *  File name   : filter.c
+ *  Description : Implementation file for metadata filters of the
+ *                Inverted Search Project.
+ *                Every active column is scanned with a branch-free loop
+ *                into a byte mask, so the compiler can vectorize it.
+ *
+ *                Functions:
+ *                - docFilter_init()
+ *                - docFilter_parse()
+ *                - docFilter_apply()
+ *                - docFilter_unknown_count()
+ *                - search_words_filtered()
+ *
+ ***********************************************************************/
+
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+
+#include "filter.h"
+#include "database.h"
+#include "postings.h"
+
+static void range_init(DocRange *range)
+{
+    range->min = LLONG_MIN;
+    range->max = LLONG_MAX;
+    range->active = 0;
+}
+
+/**
+ * Initializes an accept-all filter.
+ */
+void docFilter_init(DocFilter *filter)
+{
+    range_init(&filter->size);
+    range_init(&filter->mtime);
+    range_init(&filter->tokens);
+    filter->prefix[0] = '\0';
+}
+
+/**
+ * Parses "YYYY-MM-DD" (local midnight) or a number of seconds.
+ * Returns SUCCESS or FAILURE.
+ */
+static int parse_value(char *text, int isDate, long long *value)
+{
+    int year, month, day;
+    char extra;
+    if (isDate && sscanf(text, "%d-%d-%d%c", &year, &month, &day, &extra) == 3)
+    {
+        struct tm date = {0};
+        date.tm_year = year - 1900;
+        date.tm_mon = month - 1;
+        date.tm_mday = day;
+        date.tm_isdst = -1;
+        time_t seconds = mktime(&date);
+        if (seconds == (time_t)-1 || month < 1 || month > 12 || day < 1 || day > 31)
+            return FAILURE;
+        *value = (long long)seconds;
+        return SUCCESS;
+    }
+    char *end;
+    *value = strtoll(text, &end, 10);
+    return (end == text || *end != '\0') ? FAILURE : SUCCESS;
+}
+
+/**
+ * Narrows a range with one comparison. A strict bound past the end of
+ * the long long range leaves the range empty (min > max).
+ */
+static void range_narrow(DocRange *range, char *op, long long value)
+{
+    long long min = LLONG_MIN, max = LLONG_MAX;
+    if (strcmp(op, "<") == 0 && value == LLONG_MIN)
+        min = LLONG_MAX, max = LLONG_MIN;
+    else if (strcmp(op, "<") == 0)
+        max = value - 1;
+    else if (strcmp(op, "<=") == 0)
+        max = value;
+    else if (strcmp(op, ">") == 0 && value == LLONG_MAX)
+        min = LLONG_MAX, max = LLONG_MIN;
+    else if (strcmp(op, ">") == 0)
+        min = value + 1;
+    else if (strcmp(op, ">=") == 0)
+        min = value;
+    else
+        min = max = value;
+    if (min > range->min)
+        range->min = min;
+    if (max < range->max)
+        range->max = max;
+    range->active = 1;
+}
+
+/**
+ * Parses conditions of the form <column><op><value>.
+ */
+int docFilter_parse(DocFilter *filter, char *text)
+{
+    for (char *cond = strtok(text, " \t"); cond; cond = strtok(NULL, " \t"))
+    {
+        if (strcmp(cond, "-") == 0)
+            continue;
+
+        char column[16], op[3] = "";
+        int n = 0;
+        while (isalpha((unsigned char)cond[n]) && n < (int)sizeof(column) - 1)
+        {
+            column[n] = cond[n];
+            n++;
+        }
+        column[n] = '\0';
+        char *p = cond + n;
+        for (int k = 0; k < 2 && (*p == '<' || *p == '>' || *p == '='); k++)
+            op[k] = *p++;
+        op[2] = '\0';
+
+        int validOp = strcmp(op, "<") == 0 || strcmp(op, "<=") == 0 || strcmp(op, ">") == 0 ||
+                      strcmp(op, ">=") == 0 || strcmp(op, "=") == 0;
+        long long value;
+        DocRange *range = NULL;
+        if (strcmp(column, "size") == 0)
+            range = &filter->size;
+        else if (strcmp(column, "mtime") == 0)
+            range = &filter->mtime;
+        else if (strcmp(column, "tokens") == 0)
+            range = &filter->tokens;
+
+        if (strcmp(column, "prefix") == 0 && strcmp(op, "=") == 0 && strlen(p) < MAX_FILENAME_LENGTH)
+            strcpy(filter->prefix, p);
+        else if (range && validOp && parse_value(p, range == &filter->mtime, &value) == SUCCESS)
+            range_narrow(range, op, value);
+        else
+        {
+            fprintf(stderr, "\nERROR: Invalid filter condition '%s'\n", cond);
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Clears mask[i] for every value outside the range and for unknown
+ * values, which never pass an active range.
+ */
+static void mask_range_ll(unsigned char *mask, const long long *values, int count, DocRange *range, long long unknown)
+{
+    long long min = range->min, max = range->max;
+    for (int i = 0; i < count; i++)
+        mask[i] &= (values[i] != unknown) & (values[i] >= min) & (values[i] <= max);
+}
+
+static void mask_range_int(unsigned char *mask, const int *values, int count, DocRange *range)
+{
+    long long min = range->min, max = range->max;
+    for (int i = 0; i < count; i++)
+        mask[i] &= (values[i] != DOC_UNKNOWN) & ((long long)values[i] >= min) & ((long long)values[i] <= max);
+}
+
+/**
+ * Builds the mask column by column, then lists the ids still set.
+ */
+int docFilter_apply(DocFilter *filter, DocTable *docs, unsigned int *ids)
+{
+    unsigned char *mask = malloc(docs->count + 1);
+    if (mask == NULL)
+        return FAILURE;
+    memset(mask, 1, docs->count);
+
+    if (filter->size.active)
+        mask_range_ll(mask, docs->sizes, docs->count, &filter->size, DOC_UNKNOWN);
+    if (filter->mtime.active)
+        mask_range_ll(mask, docs->mtimes, docs->count, &filter->mtime, DOC_UNKNOWN_TIME);
+    if (filter->tokens.active)
+        mask_range_int(mask, docs->tokenCounts, docs->count, &filter->tokens);
+    if (filter->prefix[0])
+    {
+        size_t length = strlen(filter->prefix);
+        for (int i = 0; i < docs->count; i++)
+            mask[i] &= strncmp(docs->names[i], filter->prefix, length) == 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < docs->count; i++)
+    {
+        ids[count] = i;
+        count += mask[i];
+    }
+    free(mask);
+    return count;
+}
+
+/**
+ * Counts the documents that an active column skips for lack of a
+ * value, among those with the name prefix.
+ */
+int docFilter_unknown_count(DocFilter *filter, DocTable *docs)
+{
+    size_t length = strlen(filter->prefix);
+    int unknown = 0;
+    for (int i = 0; i < docs->count; i++)
+    {
+        if (length && strncmp(docs->names[i], filter->prefix, length) != 0)
+            continue;
+        unknown += (filter->size.active && docs->sizes[i] == DOC_UNKNOWN) ||
+                   (filter->mtime.active && docs->mtimes[i] == DOC_UNKNOWN_TIME) ||
+                   (filter->tokens.active && docs->tokenCounts[i] == DOC_UNKNOWN);
+    }
+    return unknown;
+}
+
+/* Search for the files passing the filter that contain all or any of the given words */
+void search_words_filtered(HashTable hashTablle[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll, DocFilter *filter)
+{
+    unsigned int *allowed = malloc((docs->count + 1) * sizeof(unsigned int));
+    unsigned int *matches = malloc((docs->count + 1) * sizeof(unsigned int));
+    unsigned int *result = malloc((docs->count + 1) * sizeof(unsigned int));
+    int allowedCount = FAILURE, matchCount = FAILURE, resultCount = 0;
+    if (allowed && matches && result)
+    {
+        allowedCount = docFilter_apply(filter, docs, allowed);
+        // No document passes → the words need not be looked up
+        if (allowedCount == 0)
+            matchCount = 0;
+        else if (allowedCount != FAILURE)
+            matchCount = match_words(hashTablle, docs, words, count, matchAll, matches);
+    }
+    if (allowedCount == FAILURE || matchCount == FAILURE)
+    {
+        fprintf(stderr, "\nERROR: Could not allocate memory for search\n");
+        free(allowed);
+        free(matches);
+        free(result);
+        return;
+    }
+
+    resultCount = postings_intersect(matches, matchCount, allowed, allowedCount, result);
+    int unknown = docFilter_unknown_count(filter, docs);
+    if (unknown > 0)
+        printf("\nINFO: %d file(s) loaded without metadata (from a backup) skipped by the size, mtime and tokens conditions\n", unknown);
+    if (resultCount == 0)
+        printf("\nNo file passing the filter contains %s of the given words\n", matchAll ? "all" : "any");
+    else
+    {
+        printf("\n%s of the given words present in (%d) file passing the filter\n", matchAll ? "All" : "Some", resultCount);
+        for (int i = 0; i < resultCount; i++)
+        {
+            // Files loaded from a backup have no metadata
+            if (docs->sizes[result[i]] == DOC_UNKNOWN)
+                printf("In File : '%s' (size unknown)\n", docs->names[result[i]]);
+            else
+                printf("In File : '%s' (%lld bytes, %d words)\n", docs->names[result[i]],
+                       docs->sizes[result[i]], docs->tokenCounts[result[i]]);
+        }
+    }
+    free(allowed);
+    free(matches);
+    free(result);
+}
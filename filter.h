@@ -0,0 +1,87 @@
+/***********************************************************************
+ *  File name   : filter.h
+ *  Description : Header file for metadata filters of the Inverted
+ *                Search Project.
+ *                A filter restricts a search to the files whose size,
+ *                modification time, token count or name prefix match.
+ *                It is evaluated once per query over the metadata
+ *                columns of the document table into a sorted id list,
+ *                which is then intersected with the query result like
+ *                any other posting list.
+ *
+ *                Filter syntax: space separated conditions
+ *                  size<4096  tokens>=100  mtime>2024-01-31  prefix=c1
+ *                with the operators < <= > >= =. Dates are local
+ *                midnight; a plain number is taken as seconds since the
+ *                epoch. "-" is the empty filter.
+ *
+ *                Functions:
+ *                - docFilter_init()
+ *                - docFilter_parse()
+ *                - docFilter_apply()
+ *                - docFilter_unknown_count()
+ *                - search_words_filtered()
+ *
+ ***********************************************************************/
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "list.h"
+#include "docs.h"
+
+/* DocRange:
+ * Inclusive range of accepted values of one column.
+ */
+typedef struct DocRange
+{
+    long long min;
+    long long max;
+    int active;                          // Set once a condition names the column
+} DocRange;
+
+/* DocFilter:
+ * Conditions on the metadata of a document. All of them must hold.
+ */
+typedef struct DocFilter
+{
+    DocRange size;
+    DocRange mtime;
+    DocRange tokens;
+    char prefix[MAX_FILENAME_LENGTH];    // Required start of the file name, "" for any
+} DocFilter;
+
+/**
+ * Initializes a filter that accepts every document.
+ */
+void docFilter_init(DocFilter *filter);
+
+/**
+ * Adds the conditions of text to the filter. Returns SUCCESS, or
+ * FAILURE (with a message) if a condition cannot be parsed.
+ */
+int docFilter_parse(DocFilter *filter, char *text);
+
+/**
+ * Stores in ids (room for docs->count ids) the sorted ids of the
+ * documents passing the filter. Files without metadata (loaded from a
+ * text backup or a version 1 packed file) fail every size, mtime and
+ * tokens condition.
+ * Returns the count, or FAILURE.
+ */
+int docFilter_apply(DocFilter *filter, DocTable *docs, unsigned int *ids);
+
+/**
+ * Returns the number of documents with the name prefix whose metadata
+ * is unknown for a size, mtime or tokens condition of the filter, i.e.
+ * the files docFilter_apply() skips for lack of metadata.
+ */
+int docFilter_unknown_count(DocFilter *filter, DocTable *docs);
+
+/**
+ * Search for the files passing the filter that contain all
+ * (matchAll = 1) or any of the given words.
+ */
+void search_words_filtered(HashTable hashTable[], DocTable *docs, char words[][MAX_WORD_LENGTH], int count, int matchAll, DocFilter *filter);
+
+#endif
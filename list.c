@@ -1,222 +1,723 @@
-/***********************************************************************
- *  File name   : list.c
- *  Description : Implementation file for linked list and hash table 
- *                operations in the Inverted Search Project.
- *                Provides functions for:
- *                - File list management
- *                - Hash table initialization and insertion
- *                - Node creation (MainNode, SubNode)
- *                - Duplicate removal
- *                - File list printing
- *
- *                Functions:
- *                - initialize_hashTable()
- *                - fileList_insert_last()
- *                - hashTable_insert_last()
- *                - create_mainNode()
- *                - create_subNode()
- *                - delete_duplicate()
- *                - print_fileList()
- * 
- ***********************************************************************/
-
-#include "list.h"
-#include "validate.h"
-
-/**
- * Initializes hash table with indices and NULL links.
- */
-void initialize_hashTable(HashTable *hashTablle, int size)
-{
-    for (int i = 0; i < size; i++)
-    {
-        hashTablle[i].index = i;
-        hashTablle[i].link = NULL;
-    }
-}
-
-/**
- * Inserts a filename at the end of FileList.
- * Returns SUCCESS, FAILURE, or DUPLICATE.
- */
-int fileList_insert_last(FileList **filelist, char *filename)
-{
-    FileList *new = malloc(sizeof(FileList));
-    if (new == NULL)
-    {
-        printf("File could not be created\n");
-        return FAILURE;
-    }
-
-    strcpy(new->filename, filename);
-    new->link = NULL;
-
-    // If list is empty, insert first node
-    if (*filelist == NULL)
-    {
-        *filelist = new;
-        return SUCCESS;
-    }
-
-    // Traverse to end of list
-    FileList *temp = *filelist;
-    while (temp && temp->link)
-    {
-        // Check duplicate
-        if (strcmp(temp->filename, filename) == 0)
-            return DUPLICATE;
-        temp = temp->link;
-    }
-
-    // Check duplicate for last node
-    if (strcmp(temp->filename, filename) == 0)
-        return DUPLICATE;
-
-    temp->link = new;
-    return SUCCESS;
-}
-
-/**
- * Inserts a word into hash table at a given index.
- * Handles creation of MainNode (word) and SubNode (filename).
- */
-int hashTable_insert_last(HashTable hashTablle[MAX_HASH_SIZE], char *filename, int index, char *word)
-{
-    if (index < 0 || index >= MAX_HASH_SIZE) 
-        return FAILURE;
-
-    MainNode *curr_m = hashTablle[index].link;
-    MainNode *prev_m = NULL;
-
-    // Traverse MainNode list for the given index
-    while (curr_m)
-    {
-        if (strcmp(curr_m->word, word) == 0)
-        {
-            // Word exists → update SubNode list
-            SubNode *curr_sub = curr_m->subLink;
-            SubNode *prev_sub = NULL;
-
-            while (curr_sub)
-            {
-                // If word already exists in this file → increment count
-                if (strcmp(curr_sub->filename, filename) == 0)
-                {
-                    curr_sub->wordCount++;
-                    return SUCCESS;
-                }
-                prev_sub = curr_sub;
-                curr_sub = curr_sub->subLink;
-            }
-
-            // Word exists but file not found → create new SubNode
-            SubNode *newSub = create_subNode(filename, 1);
-            if (newSub == NULL)
-                return FAILURE;
-
-            if (prev_sub)
-                prev_sub->subLink = newSub;
-            else
-                curr_m->subLink = newSub;
-
-            curr_m->fileCount++;
-            return SUCCESS;
-        }
-        prev_m = curr_m;
-        curr_m = curr_m->mainLink;
-    }
-
-    // Word not found → create new MainNode with SubNode
-    MainNode *newMain = create_mainNode(word, 1);
-    if (newMain == NULL)
-        return FAILURE;
-
-    newMain->subLink = create_subNode(filename, 1);
-
-    if (prev_m)
-        prev_m->mainLink = newMain;
-    else
-        hashTablle[index].link = newMain;
-
-    return SUCCESS;
-}
-
-/**
- * Creates a new MainNode for a given word.
- */
-MainNode *create_mainNode(char *word, int fileCount)
-{
-    MainNode *newMain = malloc(sizeof(MainNode));
-    if (newMain == NULL)
-        return NULL;
-
-    newMain->fileCount = fileCount;
-    strcpy(newMain->word, word);
-    newMain->mainLink = NULL;
-
-    return newMain;
-}
-
-/**
- * Creates a new SubNode for a given filename and wordCount.
- */
-SubNode *create_subNode(char *filename, int wordCount)
-{
-    SubNode *newSub = malloc(sizeof(SubNode));
-    if (newSub == NULL)
-        return NULL;
-
-    strcpy(newSub->filename, filename);
-    newSub->wordCount = wordCount;
-    newSub->subLink = NULL;
-
-    return newSub;
-}
-
-/**
- * Deletes a duplicate filename from FileList.
- * Returns SUCCESS if deleted, FAILURE if not found.
- */
-int delete_duplicate(FileList **filelist, char *filename)
-{
-    FileList *curr = *filelist;
-    FileList *prev = NULL;
-
-    while (curr)
-    {
-        if (strcmp(curr->filename, filename) == 0)
-        {
-            if (prev == NULL)
-            {
-                // First node is duplicate
-                FileList *del = *filelist;
-                *filelist = del->link;
-                free(del);
-                return SUCCESS;
-            }
-
-            // Remove middle or last node
-            prev->link = curr->link;
-            free(curr);
-            return SUCCESS;
-        }
-
-        prev = curr;
-        curr = curr->link;
-    }
-    return FAILURE;
-}
-
-/**
- * Prints the list of input filenames.
- */
-void print_fileList(FileList *fileList)
-{
-    printf("FileList: ");
-    while (fileList)
-    {
-        printf("-> %s ", fileList->filename);
-        fileList = fileList->link;
-    }
-    printf("\n");
+/***********************************************************************
+ *  File name   : list.c
+ *  Description : Implementation file for linked list and hash table 
+ *                operations in the Inverted Search Project.
+ *                Provides functions for:
+ *                - File list management
+ *                - Hash table initialization and insertion
+ *                - Node creation (MainNode, SubNode)
+ *                - Dense postings for frequent words
+ *                - Duplicate removal
+ *                - File list printing
+ *
+ *                Functions:
+ *                - initialize_hashTable()
+ *                - fileList_insert_last()
+ *                - hashTable_insert_last()
+ *                - hashTable_link_mainNode()
+ *                - hashTable_clone()
+ *                - free_hashTable()
+ *                - hashTable_sorted_terms()
+ *                - create_mainNode()
+ *                - create_subNode()
+ *                - mainNode_make_dense()
+ *                - mainNode_sort_postings()
+ *                - mainNode_merge()
+ *                - free_mainNode()
+ *                - postingCursor_init()
+ *                - postingCursor_next()
+ *                - delete_duplicate()
+ *                - print_fileList()
+ * 
+ ***********************************************************************/
+
+#include "list.h"
+#include "validate.h"
+
+/**
+ * Initializes hash table with indices and NULL links.
+ */
+void initialize_hashTable(HashTable *hashTablle, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        hashTablle[i].index = i;
+        hashTablle[i].link = NULL;
+        hashTablle[i].tail = NULL;
+        termTable_init(&hashTablle[i].terms);
+    }
+}
+
+/**
+ * Inserts a filename at the end of FileList.
+ * Returns SUCCESS, FAILURE, or DUPLICATE.
+ */
+int fileList_insert_last(FileList **filelist, char *filename)
+{
+    FileList *new = malloc(sizeof(FileList));
+    if (new == NULL)
+    {
+        printf("File could not be created\n");
+        return FAILURE;
+    }
+
+    strcpy(new->filename, filename);
+    new->link = NULL;
+
+    // If list is empty, insert first node
+    if (*filelist == NULL)
+    {
+        *filelist = new;
+        return SUCCESS;
+    }
+
+    // Traverse to end of list
+    FileList *temp = *filelist;
+    while (temp && temp->link)
+    {
+        // Check duplicate
+        if (strcmp(temp->filename, filename) == 0)
+            return DUPLICATE;
+        temp = temp->link;
+    }
+
+    // Check duplicate for last node
+    if (strcmp(temp->filename, filename) == 0)
+        return DUPLICATE;
+
+    temp->link = new;
+    return SUCCESS;
+}
+
+/**
+ * Returns the number of wordCounts allocated for a dense posting
+ * of fileCount files (the next power of two).
+ */
+static int dense_capacity(int fileCount)
+{
+    int capacity = 1;
+    while (capacity < fileCount)
+        capacity *= 2;
+    return capacity;
+}
+
+/**
+ * Adds a file that is not in the dense postings yet, with wordCount
+ * occurrences. Returns SUCCESS, or FAILURE with the postings unchanged.
+ */
+static int dense_insert(MainNode *mainNode, int docId, int wordCount)
+{
+    // Grow the counts when they are full
+    if (mainNode->fileCount == dense_capacity(mainNode->fileCount))
+    {
+        int *counts = realloc(mainNode->wordCounts, 2 * mainNode->fileCount * sizeof(int));
+        if (counts == NULL)
+            return FAILURE;
+        mainNode->wordCounts = counts;
+    }
+    int max = roaring_max(mainNode->docSet);
+    if (roaring_add(mainNode->docSet, docId) == FAILURE)
+        return FAILURE;
+
+    int pos = (docId > max) ? mainNode->fileCount : roaring_index(mainNode->docSet, docId);
+    memmove(mainNode->wordCounts + pos + 1, mainNode->wordCounts + pos, (mainNode->fileCount - pos) * sizeof(int));
+    mainNode->wordCounts[pos] = wordCount;
+    mainNode->fileCount++;
+    return SUCCESS;
+}
+
+/**
+ * Counts one more occurrence of a dense word in document docId.
+ */
+static int dense_add_word(MainNode *mainNode, int docId)
+{
+    // Words mostly come from the file being read, which has the largest id
+    int pos = (roaring_max(mainNode->docSet) == docId) ? mainNode->fileCount - 1 : roaring_index(mainNode->docSet, docId);
+    if (pos != FAILURE)
+    {
+        mainNode->wordCounts[pos]++;
+        return SUCCESS;
+    }
+    return dense_insert(mainNode, docId, 1);
+}
+
+/**
+ * Inserts a word into hash table at a given index.
+ * Handles creation of MainNode (word) and SubNode (filename).
+ * Returns SUCCESS, or FAILURE with the hash table unchanged.
+ */
+int hashTable_insert_last(HashTable hashTablle[MAX_HASH_SIZE], char *filename, int docId, int index, char *word)
+{
+    if (index < 0 || index >= MAX_HASH_SIZE) 
+        return FAILURE;
+
+    // Look the word up in the bucket's term directory
+    MainNode *curr_m = termTable_find(&hashTablle[index].terms, word);
+    if (curr_m)
+    {
+        // Word with dense postings → update its id set / counts
+        if (curr_m->docSet)
+            return dense_add_word(curr_m, docId);
+
+        // Word exists → update SubNode list
+        SubNode *curr_sub = curr_m->subLink;
+        SubNode *prev_sub = NULL;
+
+        while (curr_sub)
+        {
+            // If word already exists in this file → increment count
+            if (curr_sub->docId == docId)
+            {
+                curr_sub->wordCount++;
+                return SUCCESS;
+            }
+            prev_sub = curr_sub;
+            curr_sub = curr_sub->subLink;
+        }
+
+        // Word exists but file not found → create new SubNode
+        SubNode *newSub = create_subNode(filename, docId, 1);
+        if (newSub == NULL)
+            return FAILURE;
+
+        if (prev_sub)
+            prev_sub->subLink = newSub;
+        else
+            curr_m->subLink = newSub;
+
+        // The posting is in; should densifying fail, the list is kept and
+        // the switch is tried again with the next file
+        curr_m->fileCount++;
+        if (curr_m->fileCount > DENSE_POSTING_THRESHOLD)
+            mainNode_make_dense(curr_m);
+        return SUCCESS;
+    }
+
+    // Word not found → create new MainNode with SubNode
+    MainNode *newMain = create_mainNode(word, 1);
+    if (newMain == NULL)
+        return FAILURE;
+
+    newMain->subLink = create_subNode(filename, docId, 1);
+    if (newMain->subLink == NULL || hashTable_link_mainNode(hashTablle, index, newMain) == FAILURE)
+    {
+        free_mainNode(newMain);
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Appends a MainNode at the end of the list for the given index
+ * and registers it in the term directory.
+ */
+int hashTable_link_mainNode(HashTable hashTablle[MAX_HASH_SIZE], int index, MainNode *newMain)
+{
+    if (termTable_insert(&hashTablle[index].terms, newMain) == FAILURE)
+        return FAILURE;
+
+    if (hashTablle[index].tail)
+        hashTablle[index].tail->mainLink = newMain;
+    else
+        hashTablle[index].link = newMain;
+    hashTablle[index].tail = newMain;
+
+    return SUCCESS;
+}
+
+/**
+ * Returns a copy of a MainNode and its postings (mainLink not set).
+ */
+static MainNode *clone_mainNode(MainNode *src)
+{
+    MainNode *newMain = create_mainNode(src->word, src->fileCount);
+    if (newMain == NULL)
+        return NULL;
+
+    SubNode *prev_sub = NULL;
+    for (SubNode *sub = src->subLink; sub; sub = sub->subLink)
+    {
+        SubNode *newSub = create_subNode(sub->filename, sub->docId, sub->wordCount);
+        if (newSub == NULL)
+        {
+            free_mainNode(newMain);
+            return NULL;
+        }
+        if (prev_sub)
+            prev_sub->subLink = newSub;
+        else
+            newMain->subLink = newSub;
+        prev_sub = newSub;
+    }
+
+    if (src->docSet)
+    {
+        int capacity = dense_capacity(src->fileCount);
+        newMain->docSet = malloc(sizeof(Roaring));
+        newMain->wordCounts = malloc(capacity * sizeof(int));
+        if (newMain->docSet == NULL || newMain->wordCounts == NULL ||
+            roaring_copy(newMain->docSet, src->docSet) == FAILURE)
+        {
+            free(newMain->docSet);
+            newMain->docSet = NULL;
+            free_mainNode(newMain);
+            return NULL;
+        }
+        memcpy(newMain->wordCounts, src->wordCounts, src->fileCount * sizeof(int));
+    }
+    return newMain;
+}
+
+/**
+ * Copies every bucket, keeping the MainNode order.
+ */
+int hashTable_clone(HashTable dst[MAX_HASH_SIZE], HashTable src[MAX_HASH_SIZE])
+{
+    initialize_hashTable(dst, MAX_HASH_SIZE);
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        if (termTable_reserve(&dst[i].terms, src[i].terms.size) == FAILURE)
+        {
+            free_hashTable(dst);
+            return FAILURE;
+        }
+        for (MainNode *node = src[i].link; node; node = node->mainLink)
+        {
+            MainNode *newMain = clone_mainNode(node);
+            if (newMain == NULL || hashTable_link_mainNode(dst, i, newMain) == FAILURE)
+            {
+                if (newMain)
+                    free_mainNode(newMain);
+                free_hashTable(dst);
+                return FAILURE;
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Frees all MainNodes and term directories, leaving empty buckets.
+ */
+void free_hashTable(HashTable hashTablle[MAX_HASH_SIZE])
+{
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        MainNode *node = hashTablle[i].link;
+        while (node)
+        {
+            MainNode *next = node->mainLink;
+            free_mainNode(node);
+            node = next;
+        }
+        termTable_free(&hashTablle[i].terms);
+    }
+    initialize_hashTable(hashTablle, MAX_HASH_SIZE);
+}
+
+/* Compare function used to sort words */
+static int compare_term(const void *a, const void *b)
+{
+    return strcmp((*(MainNode * const *)a)->word, (*(MainNode * const *)b)->word);
+}
+
+/* Returns 1 if word lies in [from, to), an empty bound being open */
+static int term_in_range(const char *word, const char *from, const char *to)
+{
+    return (!from[0] || strcmp(word, from) >= 0) && (!to[0] || strcmp(word, to) < 0);
+}
+
+/**
+ * Restores the max-heap property (largest word first) of terms[0..size)
+ * from position i downwards.
+ */
+static void term_sift_down(MainNode **terms, int size, int i)
+{
+    while (1)
+    {
+        int largest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && strcmp(terms[left]->word, terms[largest]->word) > 0)
+            largest = left;
+        if (right < size && strcmp(terms[right]->word, terms[largest]->word) > 0)
+            largest = right;
+        if (largest == i)
+            return;
+        MainNode *t = terms[i];
+        terms[i] = terms[largest];
+        terms[largest] = t;
+        i = largest;
+    }
+}
+
+/**
+ * Collects the words of a range in word order. When only the first
+ * count words are wanted, a max-heap of count words keeps the smallest
+ * seen so far and is heap sorted at the end: O(n log count) instead of
+ * sorting the whole range.
+ */
+int hashTable_sorted_terms(HashTable hashTablle[MAX_HASH_SIZE], const char *from, const char *to, long count, MainNode ***terms, int *rangeCount)
+{
+    int inRange = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        for (MainNode *node = hashTablle[i].link; node; node = node->mainLink)
+            inRange += term_in_range(node->word, from, to);
+    int kept = count >= 0 && count < inRange ? (int)count : inRange;
+
+    *rangeCount = inRange;
+    *terms = malloc((kept + 1) * sizeof(MainNode *));
+    if (*terms == NULL)
+    {
+        fprintf(stderr, "\nERROR: Could not allocate memory to sort the words\n");
+        return FAILURE;
+    }
+    if (kept == 0)
+        return 0;
+
+    MainNode **heap = *terms;
+    int size = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        for (MainNode *node = hashTablle[i].link; node; node = node->mainLink)
+        {
+            if (!term_in_range(node->word, from, to))
+                continue;
+            if (kept == inRange)
+                heap[size++] = node;
+            else if (size < kept)
+            {
+                heap[size++] = node;
+                if (size == kept)
+                    for (int j = kept / 2 - 1; j >= 0; j--)
+                        term_sift_down(heap, kept, j);
+            }
+            else if (strcmp(node->word, heap[0]->word) < 0)
+            {
+                heap[0] = node;
+                term_sift_down(heap, kept, 0);
+            }
+        }
+
+    if (kept == inRange)
+        qsort(heap, kept, sizeof(MainNode *), compare_term);
+    else
+        for (int end = kept - 1; end > 0; end--)
+        {
+            MainNode *t = heap[0];
+            heap[0] = heap[end];
+            heap[end] = t;
+            term_sift_down(heap, end, 0);
+        }
+    return kept;
+}
+
+/**
+ * Creates a new MainNode for a given word.
+ */
+MainNode *create_mainNode(char *word, int fileCount)
+{
+    MainNode *newMain = malloc(sizeof(MainNode));
+    if (newMain == NULL)
+        return NULL;
+
+    newMain->fileCount = fileCount;
+    strcpy(newMain->word, word);
+    newMain->subLink = NULL;
+    newMain->docSet = NULL;
+    newMain->wordCounts = NULL;
+    newMain->mainLink = NULL;
+
+    return newMain;
+}
+
+/**
+ * Creates a new SubNode for a given filename, document id and wordCount.
+ */
+SubNode *create_subNode(char *filename, int docId, int wordCount)
+{
+    SubNode *newSub = malloc(sizeof(SubNode));
+    if (newSub == NULL)
+        return NULL;
+
+    strcpy(newSub->filename, filename);
+    newSub->docId = docId;
+    newSub->wordCount = wordCount;
+    newSub->subLink = NULL;
+
+    return newSub;
+}
+
+/* Compare function ordering SubNodes by document id */
+static int compare_subNode(const void *a, const void *b)
+{
+    const SubNode *x = *(SubNode * const *)a, *y = *(SubNode * const *)b;
+    return (x->docId > y->docId) - (x->docId < y->docId);
+}
+
+/**
+ * Moves the SubNode list of a MainNode into a Roaring id set plus
+ * a wordCount array, then frees the SubNodes.
+ */
+int mainNode_make_dense(MainNode *mainNode)
+{
+    int count = 0;
+    for (SubNode *sub = mainNode->subLink; sub; sub = sub->subLink)
+        count++;
+
+    SubNode **subs = malloc(count * sizeof(SubNode *));
+    Roaring *docSet = malloc(sizeof(Roaring));
+    int *counts = malloc(dense_capacity(count) * sizeof(int));
+    if (subs == NULL || docSet == NULL || counts == NULL)
+    {
+        free(subs);
+        free(docSet);
+        free(counts);
+        return FAILURE;
+    }
+
+    count = 0;
+    for (SubNode *sub = mainNode->subLink; sub; sub = sub->subLink)
+        subs[count++] = sub;
+    qsort(subs, count, sizeof(SubNode *), compare_subNode);
+
+    // Ids are added in ascending order, a repeated file adds to the previous count
+    roaring_init(docSet);
+    int files = 0, lastId = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (files > 0 && subs[i]->docId == lastId)
+            counts[files - 1] += subs[i]->wordCount;
+        else if (roaring_add(docSet, subs[i]->docId) == SUCCESS)
+            counts[files++] = subs[i]->wordCount;
+        else
+        {
+            // Keep the SubNode list, so no posting is lost
+            roaring_free(docSet);
+            free(docSet);
+            free(subs);
+            free(counts);
+            return FAILURE;
+        }
+        lastId = subs[i]->docId;
+    }
+    for (int i = 0; i < count; i++)
+        free(subs[i]);
+    free(subs);
+    roaring_optimize(docSet);
+
+    mainNode->subLink = NULL;
+    mainNode->docSet = docSet;
+    mainNode->wordCounts = counts;
+    mainNode->fileCount = files;
+    return SUCCESS;
+}
+
+/* Merges two SubNode lists sorted by document id, a first on ties */
+static SubNode *merge_subNodes(SubNode *a, SubNode *b)
+{
+    SubNode *head = NULL, **tail = &head;
+    while (a && b)
+    {
+        SubNode **next = (b->docId < a->docId) ? &b : &a;
+        *tail = *next;
+        tail = &(*next)->subLink;
+        *next = (*next)->subLink;
+    }
+    *tail = a ? a : b;
+    return head;
+}
+
+/* Sorts the first count SubNodes of list by document id (stable) */
+static SubNode *sort_subNodes(SubNode *list, int count)
+{
+    if (count <= 1)
+    {
+        if (list)
+            list->subLink = NULL;
+        return list;
+    }
+    SubNode *second = list;
+    for (int i = 0; i < count / 2; i++)
+        second = second->subLink;
+    SubNode *sortedSecond = sort_subNodes(second, count - count / 2);
+    return merge_subNodes(sort_subNodes(list, count / 2), sortedSecond);
+}
+
+/**
+ * Orders the SubNode list by document id; of the SubNodes of a
+ * repeated file only the first is kept.
+ */
+void mainNode_sort_postings(MainNode *mainNode)
+{
+    if (mainNode->docSet)
+        return;
+    int count = 0, sorted = 1;
+    for (SubNode *sub = mainNode->subLink; sub; sub = sub->subLink)
+    {
+        sorted &= sub->subLink == NULL || sub->docId < sub->subLink->docId;
+        count++;
+    }
+    if (sorted)
+        return;
+    mainNode->subLink = sort_subNodes(mainNode->subLink, count);
+    mainNode->fileCount = 0;
+    for (SubNode *sub = mainNode->subLink; sub; sub = sub->subLink)
+    {
+        while (sub->subLink && sub->subLink->docId == sub->docId)
+        {
+            SubNode *repeated = sub->subLink;
+            sub->subLink = repeated->subLink;
+            free(repeated);
+        }
+        mainNode->fileCount++;
+    }
+}
+
+/**
+ * Moves the postings of other into mainNode and frees other. Files
+ * that mainNode already has keep their wordCount.
+ */
+int mainNode_merge(MainNode *mainNode, MainNode *other)
+{
+    mainNode_sort_postings(other);
+    SubNode *incoming = other->subLink;
+    other->subLink = NULL;
+    free_mainNode(other);
+
+    int status = SUCCESS;
+    if (mainNode->docSet)
+    {
+        while (incoming)
+        {
+            SubNode *sub = incoming;
+            incoming = sub->subLink;
+            if (status == SUCCESS && !roaring_contains(mainNode->docSet, sub->docId))
+                status = dense_insert(mainNode, sub->docId, sub->wordCount);
+            free(sub);
+        }
+        return status;
+    }
+
+    // Both lists are in id order: one walk places every new file
+    SubNode **link = &mainNode->subLink;
+    while (incoming)
+    {
+        SubNode *sub = incoming;
+        incoming = sub->subLink;
+        while (*link && (*link)->docId < sub->docId)
+            link = &(*link)->subLink;
+        if (*link && (*link)->docId == sub->docId)
+        {
+            free(sub);
+            continue;
+        }
+        sub->subLink = *link;
+        *link = sub;
+        mainNode->fileCount++;
+    }
+    if (mainNode->fileCount > DENSE_POSTING_THRESHOLD)
+        mainNode_make_dense(mainNode);
+    return SUCCESS;
+}
+
+/**
+ * Frees a MainNode, its SubNodes or dense postings.
+ */
+void free_mainNode(MainNode *mainNode)
+{
+    SubNode *sub = mainNode->subLink;
+    while (sub)
+    {
+        SubNode *next = sub->subLink;
+        free(sub);
+        sub = next;
+    }
+    if (mainNode->docSet)
+    {
+        roaring_free(mainNode->docSet);
+        free(mainNode->docSet);
+    }
+    free(mainNode->wordCounts);
+    free(mainNode);
+}
+
+/**
+ * Positions a cursor before the first file of a MainNode.
+ */
+void postingCursor_init(PostingCursor *cursor, MainNode *mainNode)
+{
+    cursor->node = mainNode;
+    cursor->sub = mainNode->subLink;
+    cursor->rank = 0;
+    if (mainNode->docSet)
+        roaring_iter_init(&cursor->iter, mainNode->docSet);
+}
+
+/**
+ * Returns the next (docId, wordCount) of the word, in list order for
+ * SubNodes and ascending id order for dense postings.
+ */
+int postingCursor_next(PostingCursor *cursor, int *docId, int *wordCount)
+{
+    if (cursor->node->docSet)
+    {
+        unsigned int id;
+        if (roaring_iterate(&cursor->iter, &id) == 0)
+            return 0;
+        *docId = (int)id;
+        *wordCount = cursor->node->wordCounts[cursor->rank++];
+        return 1;
+    }
+    if (cursor->sub == NULL)
+        return 0;
+    *docId = cursor->sub->docId;
+    *wordCount = cursor->sub->wordCount;
+    cursor->sub = cursor->sub->subLink;
+    return 1;
+}
+
+/**
+ * Deletes a duplicate filename from FileList.
+ * Returns SUCCESS if deleted, FAILURE if not found.
+ */
+int delete_duplicate(FileList **filelist, char *filename)
+{
+    FileList *curr = *filelist;
+    FileList *prev = NULL;
+
+    while (curr)
+    {
+        if (strcmp(curr->filename, filename) == 0)
+        {
+            if (prev == NULL)
+            {
+                // First node is duplicate
+                FileList *del = *filelist;
+                *filelist = del->link;
+                free(del);
+                return SUCCESS;
+            }
+
+            // Remove middle or last node
+            prev->link = curr->link;
+            free(curr);
+            return SUCCESS;
+        }
+
+        prev = curr;
+        curr = curr->link;
+    }
+    return FAILURE;
+}
+
+/**
+ * Prints the list of input filenames.
+ */
+void print_fileList(FileList *fileList)
+{
+    printf("FileList: ");
+    while (fileList)
+    {
+        printf("-> %s ", fileList->filename);
+        fileList = fileList->link;
+    }
+    printf("\n");
 }
\ No newline at end of file
@@ -1,121 +1,224 @@
-/***********************************************************************
- *  File name   : list.h
- *  Description : Header file for linked list and hash table structures 
- *                used in the Inverted Search Project.
- *                Contains structure definitions and function prototypes 
- *                for managing:
- *                - File list (input files)
- *                - Main node (word entries)
- *                - Sub node (filename and word count mapping)
- *                - Hash table (inverted index)
- *
- *                Functions:
- *                - fileList_insert_last()
- *                - initialize_hashTable()
- *                - hashTable_insert_last()
- *                - create_mainNode()
- *                - create_subNode()
- *                - delete_duplicate()
- *                - print_fileList()
- * 
- ***********************************************************************/
-
-#ifndef LIST_H
-#define LIST_H
-
-/* Required Header Files */
-#include <stdio.h>
-#include <string.h>
-#include <ctype.h>
-#include <stdlib.h>
-
-/* Predefined Macros */
-#define MAX_FILENAME_LENGTH 20   // Maximum length of filename
-#define MAX_WORD_LENGTH 20       // Maximum length of a word
-#define MAX_HASH_SIZE 28         // Hash table size (A-Z + extra buckets)
-
-#define SUCCESS 0
-#define FAILURE -1
-#define DUPLICATE -2
-#define LIST_EMPTY -3
-
-/* ----------- Structures ----------- */
-
-/* SubNode:
- * Stores filename and the count of occurrences of a word in that file.
- */
-typedef struct SubNode
-{
-    char filename[MAX_FILENAME_LENGTH];
-    int wordCount;
-    struct SubNode *subLink;   // Pointer to next SubNode
-} SubNode;
-
-/* MainNode:
- * Stores a unique word, count of files it appears in,
- * and a linked list of SubNodes (file → wordCount mapping).
- */
-typedef struct MainNode
-{
-    char word[MAX_WORD_LENGTH];
-    int fileCount;
-    struct SubNode *subLink;   // Linked list of files containing this word
-    struct MainNode *mainLink; // Pointer to next MainNode
-} MainNode;
-
-/* FileList:
- * Singly linked list to store input filenames.
- */
-typedef struct FileList
-{
-    char filename[MAX_FILENAME_LENGTH];
-    struct FileList *link;     // Pointer to next file in the list
-} FileList;
-
-/* HashTable:
- * Stores index (bucket) and pointer to MainNode linked list.
- */
-typedef struct HashTable
-{
-    int index;                 // Hash index (0-27)
-    struct MainNode *link;     // Linked list of MainNodes at this index
-} HashTable;
-
-/* ----------- Function Prototypes ----------- */
-
-/**
- * Inserts a filename at the end of FileList.
- */
-int fileList_insert_last(FileList **filelist, char * filename);
-
-/**
- * Initializes the hash table with NULL links.
- */
-void initialize_hashTable(HashTable *hashTablle,int size);
-
-/**
- * Inserts a word into hash table under a given index, along with filename.
- */
-int hashTable_insert_last(HashTable hashTablle[MAX_HASH_SIZE], char *filename, int index, char *word);
-
-/**
- * Creates a new MainNode for a word.
- */
-MainNode *create_mainNode(char * word, int fileCount);
-
-/**
- * Creates a new SubNode for a filename and wordCount.
- */
-SubNode *create_subNode(char *filename,int wordCount);
-
-/**
- * Deletes duplicate filenames from FileList.
- */
-int delete_duplicate(FileList **filelist, char *filename);
-
-/**
- * Prints the list of input files.
- */
-void print_fileList(FileList *fileList);
-
+/***********************************************************************
+ *  File name   : list.h
+ *  Description : Header file for linked list and hash table structures 
+ *                used in the Inverted Search Project.
+ *                Contains structure definitions and function prototypes 
+ *                for managing:
+ *                - File list (input files)
+ *                - Main node (word entries)
+ *                - Sub node (filename and word count mapping)
+ *                - Dense postings (document id set + word counts)
+ *                - Hash table (inverted index)
+ *
+ *                Functions:
+ *                - fileList_insert_last()
+ *                - initialize_hashTable()
+ *                - hashTable_insert_last()
+ *                - hashTable_link_mainNode()
+ *                - hashTable_clone()
+ *                - free_hashTable()
+ *                - hashTable_sorted_terms()
+ *                - create_mainNode()
+ *                - create_subNode()
+ *                - mainNode_make_dense()
+ *                - mainNode_sort_postings()
+ *                - mainNode_merge()
+ *                - free_mainNode()
+ *                - postingCursor_init()
+ *                - postingCursor_next()
+ *                - delete_duplicate()
+ *                - print_fileList()
+ * 
+ ***********************************************************************/
+
+#ifndef LIST_H
+#define LIST_H
+
+/* Required Header Files */
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "termtable.h"
+#include "roaring.h"
+
+/* Predefined Macros */
+#define MAX_FILENAME_LENGTH 20   // Maximum length of filename
+#define MAX_WORD_LENGTH 20       // Maximum length of a word
+#define MAX_HASH_SIZE 28         // Hash table size (A-Z + extra buckets)
+#define MAX_QUERY_WORDS 10       // Maximum words in a multi-word search
+
+#ifndef DENSE_POSTING_THRESHOLD
+#define DENSE_POSTING_THRESHOLD 64   // fileCount above which a word uses dense postings
+#endif
+
+#define SUCCESS 0
+#define FAILURE -1
+#define DUPLICATE -2
+#define LIST_EMPTY -3
+
+/* ----------- Structures ----------- */
+
+/* SubNode:
+ * Stores filename, its document id and the count of occurrences
+ * of a word in that file.
+ */
+typedef struct SubNode
+{
+    char filename[MAX_FILENAME_LENGTH];
+    int docId;                 // Document id of filename (see DocTable)
+    int wordCount;
+    struct SubNode *subLink;   // Pointer to next SubNode
+} SubNode;
+
+/* MainNode:
+ * Stores a unique word, count of files it appears in,
+ * and a linked list of SubNodes (file → wordCount mapping).
+ * Once fileCount passes DENSE_POSTING_THRESHOLD the SubNodes are
+ * replaced by a compressed set of document ids and a side array
+ * holding the wordCount of each id, in ascending id order.
+ */
+typedef struct MainNode
+{
+    char word[MAX_WORD_LENGTH];
+    int fileCount;
+    struct SubNode *subLink;   // Linked list of files containing this word
+    Roaring *docSet;           // Dense postings: ids of files containing this word
+    int *wordCounts;           // Dense postings: wordCount of each id in docSet
+    struct MainNode *mainLink; // Pointer to next MainNode
+} MainNode;
+
+/* FileList:
+ * Singly linked list to store input filenames.
+ */
+typedef struct FileList
+{
+    char filename[MAX_FILENAME_LENGTH];
+    struct FileList *link;     // Pointer to next file in the list
+} FileList;
+
+/* HashTable:
+ * Stores index (bucket), pointer to MainNode linked list and
+ * a term directory used to find a word without walking the list.
+ */
+typedef struct HashTable
+{
+    int index;                 // Hash index (0-27)
+    struct MainNode *link;     // Linked list of MainNodes at this index
+    struct MainNode *tail;     // Last MainNode of the list (for appends)
+    TermTable terms;           // Word -> MainNode directory for this index
+} HashTable;
+
+/* PostingCursor:
+ * Walks the files of a MainNode, whichever form its postings have.
+ */
+typedef struct PostingCursor
+{
+    MainNode *node;
+    SubNode *sub;              // Next SubNode (list postings)
+    RoaringIter iter;          // Position in docSet (dense postings)
+    int rank;                  // Index of the next wordCount (dense postings)
+} PostingCursor;
+
+/* ----------- Function Prototypes ----------- */
+
+/**
+ * Inserts a filename at the end of FileList.
+ */
+int fileList_insert_last(FileList **filelist, char * filename);
+
+/**
+ * Initializes the hash table with NULL links.
+ */
+void initialize_hashTable(HashTable *hashTablle,int size);
+
+/**
+ * Inserts a word into hash table under a given index, along with
+ * filename and its document id. Returns SUCCESS, or FAILURE with the
+ * hash table unchanged (a word whose switch to dense postings fails
+ * keeps its SubNode list and counts as inserted).
+ */
+int hashTable_insert_last(HashTable hashTablle[MAX_HASH_SIZE], char *filename, int docId, int index, char *word);
+
+/**
+ * Appends an already built MainNode to the given index and
+ * registers its word in the term directory.
+ */
+int hashTable_link_mainNode(HashTable hashTablle[MAX_HASH_SIZE], int index, MainNode *newMain);
+
+/**
+ * Builds in dst (initialized by the call) a deep copy of src.
+ * Returns SUCCESS or FAILURE.
+ */
+int hashTable_clone(HashTable dst[MAX_HASH_SIZE], HashTable src[MAX_HASH_SIZE]);
+
+/**
+ * Frees every MainNode and term directory of the hash table.
+ */
+void free_hashTable(HashTable hashTablle[MAX_HASH_SIZE]);
+
+/**
+ * Stores in *terms (freed by the caller) the words w of the hash table
+ * with from <= w < to ("" for no bound), in word order. With count >= 0
+ * only the first count of them are kept, without sorting the others.
+ * Sets *rangeCount to the number of words in the range. Returns the
+ * number of words stored, or FAILURE.
+ */
+int hashTable_sorted_terms(HashTable hashTablle[MAX_HASH_SIZE], const char *from, const char *to, long count, MainNode ***terms, int *rangeCount);
+
+/**
+ * Creates a new MainNode for a word.
+ */
+MainNode *create_mainNode(char * word, int fileCount);
+
+/**
+ * Creates a new SubNode for a filename, document id and wordCount.
+ */
+SubNode *create_subNode(char *filename, int docId, int wordCount);
+
+/**
+ * Replaces the SubNode list of a MainNode by dense postings.
+ * Returns SUCCESS, or FAILURE with the SubNode list left in place.
+ */
+int mainNode_make_dense(MainNode *mainNode);
+
+/**
+ * Orders the SubNode list of a MainNode by document id, keeping only
+ * the first SubNode of a repeated file.
+ */
+void mainNode_sort_postings(MainNode *mainNode);
+
+/**
+ * Moves the postings of other (SubNode list) into mainNode, which
+ * keeps its own wordCount for files both have, and frees other.
+ * Returns SUCCESS, or FAILURE if dense postings could not grow.
+ */
+int mainNode_merge(MainNode *mainNode, MainNode *other);
+
+/**
+ * Frees a MainNode together with its postings.
+ */
+void free_mainNode(MainNode *mainNode);
+
+/**
+ * Positions a cursor before the first file of a MainNode.
+ */
+void postingCursor_init(PostingCursor *cursor, MainNode *mainNode);
+
+/**
+ * Returns 1 and the next document id / wordCount, or 0 at the end.
+ */
+int postingCursor_next(PostingCursor *cursor, int *docId, int *wordCount);
+
+/**
+ * Deletes duplicate filenames from FileList.
+ */
+int delete_duplicate(FileList **filelist, char *filename);
+
+/**
+ * Prints the list of input files.
+ */
+void print_fileList(FileList *fileList);
+
 #endif
\ No newline at end of file
@@ -4,6 +4,9 @@
  *                Handles command-line arguments, initializes the hash
  *                table, validates input files, and provides a menu-driven
  *                interface to manage the database.
+ *                Create and Update build a new index version on a copy of
+ *                the current one and publish it once it succeeded, so readers
+ *                always see a complete version.
  *
  *                Menu Options:
  *                1. Create Database
@@ -11,23 +14,94 @@
  *                3. Search Word
  *                4. Save Database
  *                5. Update Database
+ *                6. Search All Words (AND)
+ *                7. Search Any Word (OR)
+ *                8. Create Database File (low memory)
+ *                9. Sharded Search (starts the shards on first use)
+ *                a. Save Packed Database
+ *                b. Search Word in Packed Database File
+ *                c. Update Database from Packed File
+ *                d. Search Words with File Filter
+ *                e. Index Statistics
+ *                f. Top N Words
+ *                g. Words Unique to a File
+ *                h. Export Database (TSV/JSONL, paginated)
+ *                i. Find Near-Duplicate Files
+ *                j. Search Words, collapsing Near-Duplicates
  *                0. Exit
  *
  *                Functions:
  *                - main()
- *                - initialize_hashTable()
+ *                - read_query_line()
+ *                - read_query_words()
+ *                - snapshotStore_init()
+ *                - snapshot_clone()
+ *                - snapshot_acquire()
+ *                - snapshot_release()
+ *                - snapshot_publish()
  *                - read_and_validate_args()
  *                - create_database()
  *                - display_database()
  *                - search_word()
+ *                - search_words()
  *                - save_database()
  *                - update_database()
+ *                - create_database_external()
+ *                - shardCluster_start()
+ *                - shardCluster_search()
+ *                - shardCluster_stop()
+ *                - save_packed_database()
+ *                - update_database_packed()
+ *                - packedIndex_open()
+ *                - packedIndex_search()
+ *                - packedIndex_close()
+ *                - docFilter_init()
+ *                - docFilter_parse()
+ *                - search_words_filtered()
+ *                - print_index_stats()
+ *                - print_top_terms()
+ *                - print_unique_terms()
+ *                - exportOptions_init()
+ *                - exportOptions_parse()
+ *                - export_database()
+ *                - print_near_duplicates()
+ *                - search_words_collapsed()
  * 
  ***********************************************************************/
 
 #include "list.h"
 #include "validate.h"
 #include "database.h"
+#include "external.h"
+#include "snapshot.h"
+#include "shard.h"
+#include "packed.h"
+#include "filter.h"
+#include "stats.h"
+#include "export.h"
+#include "dedup.h"
+
+#define QUERY_LINE_LENGTH (MAX_QUERY_WORDS * MAX_WORD_LENGTH)   // Longest line of words or options
+
+/* Reads the rest of a line (up to QUERY_LINE_LENGTH - 1 characters) into line */
+static void read_query_line(char line[QUERY_LINE_LENGTH])
+{
+    char format[16];
+    snprintf(format, sizeof(format), " %%%d[^\n]", QUERY_LINE_LENGTH - 1);
+    if (scanf(format, line) != 1)
+        line[0] = '\0';
+}
+
+/* Reads a line and splits it into up to MAX_QUERY_WORDS words. Returns the count */
+static int read_query_words(char words[][MAX_WORD_LENGTH])
+{
+    char line[QUERY_LINE_LENGTH];
+    int count = 0;
+    read_query_line(line);
+    for (char *token = strtok(line, " \t"); token && count < MAX_QUERY_WORDS; token = strtok(NULL, " \t"))
+        snprintf(words[count++], MAX_WORD_LENGTH, "%s", token);
+    return count;
+}
 
 int main(int argc, char ** argv)
 {
@@ -39,10 +113,12 @@ int main(int argc, char ** argv)
     }
 
     FileList *filelist = NULL;                // Linked list to store input file names
-    HashTable hashTablle[MAX_HASH_SIZE];      // Hash table for inverted index
+    SnapshotStore store;                      // Published versions of the inverted index
+    IndexSnapshot *snapshot;                  // Version being read or built
 
-    // Initialize the hash table
-    initialize_hashTable(hashTablle, MAX_HASH_SIZE);
+    // Publish an empty index as version 0
+    if (snapshotStore_init(&store) == FAILURE)
+        return FAILURE;
 
     // Validate input files and build the file list
     if (read_and_validate_args(&filelist, argv, argc) == FAILURE)
@@ -60,7 +136,21 @@ int main(int argc, char ** argv)
 
     char choice;                              // User menu choice
     char word[MAX_WORD_LENGTH];               // Word to search
-    char filename[MAX_FILENAME_LENGTH];       // Temp filename (unused here, but reserved)
+    char queryWords[MAX_QUERY_WORDS][MAX_WORD_LENGTH];   // Words split from query
+    int queryCount;
+    int budgetMB;                             // Memory budget of the low memory build
+    int shardCount;                           // Worker processes of the sharded mode
+    char matchMode;                           // 'a' for AND, 'o' for OR in sharded search
+    ShardCluster cluster = { .count = 0 };    // Sharded index, started on first use
+    PackedIndex packed;                       // Packed file opened for a search
+    DocFilter filter;                         // Metadata conditions of a filtered search
+    char filterText[QUERY_LINE_LENGTH];       // Filter as typed
+    int topCount;                             // N of a top-N query
+    char topMode;                             // 'e' for exact, 's' for the ingest sketch
+    ExportOptions exportOptions;              // Format, range and page of an export
+    char exportFormat;                        // 't' for TSV, 'j' for JSONL
+    double threshold;                         // Similarity of near-duplicate files
+    char filename[MAX_FILENAME_LENGTH];       // File name of a per-file query
     char backup[MAX_FILENAME_LENGTH];         // Backup file name
 
     int create_flag = 0, update_flag = 0;     // Flags to restrict duplicate database operations
@@ -76,6 +166,20 @@ int main(int argc, char ** argv)
         printf("3. Search Word\n");
         printf("4. Save Database\n");
         printf("5. Update Database\n");
+        printf("6. Search All Words (AND)\n");
+        printf("7. Search Any Word (OR)\n");
+        printf("8. Create Database File (low memory)\n");
+        printf("9. Sharded Search\n");
+        printf("a. Save Packed Database\n");
+        printf("b. Search Word in Packed Database File\n");
+        printf("c. Update Database from Packed File\n");
+        printf("d. Search Words with File Filter\n");
+        printf("e. Index Statistics\n");
+        printf("f. Top N Words\n");
+        printf("g. Words Unique to a File\n");
+        printf("h. Export Database (TSV/JSONL)\n");
+        printf("i. Find Near-Duplicate Files\n");
+        printf("j. Search Words, collapsing Near-Duplicates\n");
         printf("0. Exit\n"); 
         printf("Enter choice: ");
         scanf(" %c", &choice);
@@ -88,27 +192,41 @@ int main(int argc, char ** argv)
                     fprintf(stderr, "\nINFO: Database already created\n");
                     break;
                 }
-                create_database(filelist, hashTablle);
+                if ((snapshot = snapshot_clone(&store)) == NULL)
+                    break;
+                // A failed build is dropped, readers keep the current version
+                if (create_database(filelist, snapshot->hashTable, &snapshot->docs, &snapshot->sketch) == FAILURE)
+                {
+                    snapshot_release(snapshot);
+                    break;
+                }
+                snapshot_publish(&store, snapshot);
                 create_flag = 1;
                 break;
 
             case '2':
                 // Display the database contents
-                display_database(hashTablle);
+                snapshot = snapshot_acquire(&store);
+                display_database(snapshot->hashTable, &snapshot->docs);
+                snapshot_release(snapshot);
                 break; 
 
             case '3':
                 // Search a word in the database
                 printf("Enter word to search: ");
                 scanf(" %s", word);
-                search_word(hashTablle, word);
+                snapshot = snapshot_acquire(&store);
+                search_word(snapshot->hashTable, &snapshot->docs, word);
+                snapshot_release(snapshot);
                 break;
 
             case '4':
                 // Save database to backup file
                 printf("Enter backup file name to save: ");
                 scanf(" %s", backup);
-                save_database(hashTablle, backup);
+                snapshot = snapshot_acquire(&store);
+                save_database(snapshot->hashTable, &snapshot->docs, backup);
+                snapshot_release(snapshot);
                 break;
 
             case '5':
@@ -125,13 +243,185 @@ int main(int argc, char ** argv)
                     fprintf(stderr, "\nINFO: Database already updated for file %s\n", backup);
                     break;
                 }
+                if ((snapshot = snapshot_clone(&store)) == NULL)
+                    break;
+                if (update_database(&filelist, snapshot->hashTable, &snapshot->docs, &snapshot->sketch, backup) == FAILURE)
+                {
+                    snapshot_release(snapshot);
+                    break;
+                }
+                fileList_insert_last(&backup_list, backup);
+                snapshot_publish(&store, snapshot);
+                update_flag = 1;
+                break;
+
+            case '6':
+            case '7':
+                // Search several words, combining their file lists
+                printf("Enter words to search (separated by spaces): ");
+                queryCount = read_query_words(queryWords);
+                snapshot = snapshot_acquire(&store);
+                search_words(snapshot->hashTable, &snapshot->docs, queryWords, queryCount, choice == '6');
+                snapshot_release(snapshot);
+                break;
+
+            case '8':
+                // Build the database straight into a backup file with bounded memory
+                printf("Enter backup file name to create: ");
+                scanf(" %s", backup);
+                printf("Enter memory budget in MB (0 for default %d): ", DEFAULT_MEMORY_BUDGET_MB);
+                if (scanf("%d", &budgetMB) != 1 || budgetMB <= 0)
+                    budgetMB = DEFAULT_MEMORY_BUDGET_MB;
+                create_database_external(filelist, backup, budgetMB);
+                break;
+
+            case '9':
+                // Search the input files through worker processes, each owning part of them
+                if (cluster.count == 0)
+                {
+                    printf("Enter number of shards: ");
+                    if (scanf("%d", &shardCount) != 1 || shardCluster_start(&cluster, filelist, shardCount) == FAILURE)
+                        break;
+                }
+                printf("Match all or any of the words? (a/o): ");
+                scanf(" %c", &matchMode);
+                printf("Enter words to search (separated by spaces): ");
+                queryCount = read_query_words(queryWords);
+                shardCluster_search(&cluster, queryWords, queryCount, matchMode != 'o');
+                break;
+
+            case 'a':
+                // Save database to a compressed file
+                printf("Enter packed file name to save: ");
+                scanf(" %s", backup);
+                snapshot = snapshot_acquire(&store);
+                save_packed_database(snapshot->hashTable, &snapshot->docs, backup);
+                snapshot_release(snapshot);
+                break;
+
+            case 'b':
+                // Search a word straight from a packed file, reading one block
+                printf("Enter packed file name: ");
+                scanf(" %s", backup);
+                printf("Enter word to search: ");
+                scanf(" %s", word);
+                if (packedIndex_open(&packed, backup) == FAILURE)
+                    break;
+                packedIndex_search(&packed, word);
+                packedIndex_close(&packed);
+                break;
+
+            case 'c':
+                // Update database from a packed file, under the same rules as option 5
+                if (create_flag)
+                {
+                    fprintf(stderr, "\nINFO: Database already created. Cannot update Database\n");
+                    break;
+                }
+                printf("Enter the packed file to update: ");
+                scanf("%s", backup);
+                if(delete_duplicate(&backup_list, backup) == SUCCESS)
+                {
+                    fprintf(stderr, "\nINFO: Database already updated for file %s\n", backup);
+                    break;
+                }
+                if ((snapshot = snapshot_clone(&store)) == NULL)
+                    break;
+                if (update_database_packed(&filelist, snapshot->hashTable, &snapshot->docs, &snapshot->sketch, backup) == FAILURE)
+                {
+                    snapshot_release(snapshot);
+                    break;
+                }
                 fileList_insert_last(&backup_list, backup);
-                update_database(&filelist, hashTablle, backup);
+                snapshot_publish(&store, snapshot);
                 update_flag = 1;
                 break;
 
+            case 'd':
+                // Search several words among the files whose metadata match a filter
+                printf("Enter words to search (separated by spaces): ");
+                queryCount = read_query_words(queryWords);
+                printf("Match all or any of the words? (a/o): ");
+                scanf(" %c", &matchMode);
+                printf("Enter filter (e.g. size<4096 mtime>=2024-01-31 tokens>100 prefix=c1, - for none): ");
+                read_query_line(filterText);
+                docFilter_init(&filter);
+                if (docFilter_parse(&filter, filterText) == FAILURE)
+                    break;
+                snapshot = snapshot_acquire(&store);
+                search_words_filtered(snapshot->hashTable, &snapshot->docs, queryWords, queryCount, matchMode != 'o', &filter);
+                snapshot_release(snapshot);
+                break;
+
+            case 'e':
+                // Collection totals and the vocabulary of every file
+                snapshot = snapshot_acquire(&store);
+                print_index_stats(snapshot->hashTable, &snapshot->docs);
+                snapshot_release(snapshot);
+                break;
+
+            case 'f':
+                // Most frequent words, exact or from the sketch kept during ingest
+                printf("Enter N: ");
+                if (scanf("%d", &topCount) != 1)
+                    topCount = 0;
+                printf("Exact count or ingest sketch? (e/s): ");
+                scanf(" %c", &topMode);
+                snapshot = snapshot_acquire(&store);
+                print_top_terms(snapshot->hashTable, &snapshot->sketch, topCount, topMode == 's');
+                snapshot_release(snapshot);
+                break;
+
+            case 'g':
+                // Words that no other file contains
+                printf("Enter file name: ");
+                scanf(" %s", filename);
+                snapshot = snapshot_acquire(&store);
+                print_unique_terms(snapshot->hashTable, &snapshot->docs, filename);
+                snapshot_release(snapshot);
+                break;
+
+            case 'h':
+                // Stream the words, or a range / page of them, for other tools
+                printf("Enter export file name (- for screen): ");
+                scanf(" %s", backup);
+                printf("Format? (t for TSV, j for JSONL): ");
+                scanf(" %c", &exportFormat);
+                printf("Enter range and page (e.g. from=b to=d limit=100 page=2, - for all): ");
+                read_query_line(filterText);
+                exportOptions_init(&exportOptions);
+                exportOptions.format = exportFormat == 'j' ? EXPORT_JSONL : EXPORT_TSV;
+                if (exportOptions_parse(&exportOptions, filterText) == FAILURE)
+                    break;
+                snapshot = snapshot_acquire(&store);
+                export_database(snapshot->hashTable, &snapshot->docs, &exportOptions, backup);
+                snapshot_release(snapshot);
+                break;
+
+            case 'i':
+                // Groups of files with almost the same content, through the LSH index
+                printf("Enter similarity threshold (0 for default %.2f): ", NEAR_DUPLICATE_THRESHOLD);
+                if (scanf("%lf", &threshold) != 1 || threshold == 0)
+                    threshold = NEAR_DUPLICATE_THRESHOLD;
+                snapshot = snapshot_acquire(&store);
+                print_near_duplicates(&snapshot->docs, threshold);
+                snapshot_release(snapshot);
+                break;
+
+            case 'j':
+                // Search several words, listing one file per near-duplicate group
+                printf("Match all or any of the words? (a/o): ");
+                scanf(" %c", &matchMode);
+                printf("Enter words to search (separated by spaces): ");
+                queryCount = read_query_words(queryWords);
+                snapshot = snapshot_acquire(&store);
+                search_words_collapsed(snapshot->hashTable, &snapshot->docs, queryWords, queryCount, matchMode != 'o');
+                snapshot_release(snapshot);
+                break;
+
             case '0':
                 // Exit program
+                shardCluster_stop(&cluster);
                 printf("Exiting\n");
                 break;
 
@@ -0,0 +1,220 @@
+/***********************************************************************
+ *  File name   : minhash.c
+ *  Description : Implementation file for MinHash signatures and the
+ *                LSH index of the Inverted Search Project.
+ *
+ *                Functions:
+ *                - minhash_init()
+ *                - minhash_shingle()
+ *                - minhash_add()
+ *                - minhash_is_empty()
+ *                - minhash_similarity()
+ *                - lsh_init()
+ *                - lsh_insert()
+ *                - lsh_candidates()
+ *                - lsh_clone()
+ *                - lsh_free()
+ *
+ ***********************************************************************/
+
+#include <limits.h>
+
+#include "minhash.h"
+
+#define LSH_ROWS (MINHASH_SIZE / LSH_BANDS)
+
+/* ----------- Signatures ----------- */
+
+void minhash_init(unsigned int signature[MINHASH_SIZE])
+{
+    for (int k = 0; k < MINHASH_SIZE; k++)
+        signature[k] = UINT_MAX;
+}
+
+unsigned long long minhash_shingle(unsigned long long *previous, const char *word)
+{
+    unsigned long long hash = term_hash(word);
+    unsigned long long shingle = hash ^ (*previous * 0x9E3779B97F4A7C15ULL);
+    *previous = hash;
+    shingle ^= shingle >> 31;
+    shingle *= 0xBF58476D1CE4E5B9ULL;
+    return shingle ^ (shingle >> 27);
+}
+
+/**
+ * Hash function k is h1 + k * h2 (mod 2^32), both halves taken from
+ * the shingle hash, so one hash per shingle feeds every minimum.
+ */
+void minhash_add(unsigned int signature[MINHASH_SIZE], unsigned long long shingle)
+{
+    unsigned int h1 = (unsigned int)shingle;
+    unsigned int h2 = (unsigned int)(shingle >> 32) | 1;
+    for (int k = 0; k < MINHASH_SIZE; k++)
+    {
+        unsigned int value = h1 + (unsigned int)k * h2;
+        if (value < signature[k])
+            signature[k] = value;
+    }
+}
+
+int minhash_is_empty(const unsigned int signature[MINHASH_SIZE])
+{
+    for (int k = 0; k < MINHASH_SIZE; k++)
+        if (signature[k] != UINT_MAX)
+            return 0;
+    return 1;
+}
+
+double minhash_similarity(const unsigned int a[MINHASH_SIZE], const unsigned int b[MINHASH_SIZE])
+{
+    int equal = 0;
+    for (int k = 0; k < MINHASH_SIZE; k++)
+        equal += a[k] == b[k];
+    return (double)equal / MINHASH_SIZE;
+}
+
+/* ----------- LSH index ----------- */
+
+void lsh_init(LshIndex *index)
+{
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->heads = NULL;
+    index->headCount = 0;
+}
+
+/* Key of one band: its number and its rows, mixed */
+static unsigned long long band_key(const unsigned int signature[MINHASH_SIZE], int band)
+{
+    unsigned long long key = (unsigned long long)band * 0x9E3779B97F4A7C15ULL;
+    for (int r = 0; r < LSH_ROWS; r++)
+    {
+        key ^= signature[band * LSH_ROWS + r];
+        key *= 0xBF58476D1CE4E5B9ULL;
+        key ^= key >> 29;
+    }
+    return key;
+}
+
+/* Doubles the slots and re-links every entry */
+static int grow_heads(LshIndex *index)
+{
+    int headCount = index->headCount ? index->headCount * 2 : 64;
+    int *heads = malloc(headCount * sizeof(int));
+    if (heads == NULL)
+        return FAILURE;
+    for (int i = 0; i < headCount; i++)
+        heads[i] = FAILURE;
+    for (int i = 0; i < index->count; i++)
+    {
+        int slot = (int)(index->entries[i].key & (headCount - 1));
+        index->entries[i].next = heads[slot];
+        heads[slot] = i;
+    }
+    free(index->heads);
+    index->heads = heads;
+    index->headCount = headCount;
+    return SUCCESS;
+}
+
+int lsh_insert(LshIndex *index, int docId, const unsigned int signature[MINHASH_SIZE])
+{
+    if (index->count + LSH_BANDS > index->capacity)
+    {
+        int capacity = index->capacity ? index->capacity * 2 : 16 * LSH_BANDS;
+        LshEntry *entries = realloc(index->entries, capacity * sizeof(LshEntry));
+        if (entries == NULL)
+            return FAILURE;
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    // Keep chains short: at most one entry per slot on average
+    while (index->count + LSH_BANDS > index->headCount)
+        if (grow_heads(index) == FAILURE)
+            return FAILURE;
+
+    for (int band = 0; band < LSH_BANDS; band++)
+    {
+        LshEntry *entry = &index->entries[index->count];
+        int slot;
+        entry->key = band_key(signature, band);
+        entry->docId = docId;
+        slot = (int)(entry->key & (index->headCount - 1));
+        entry->next = index->heads[slot];
+        index->heads[slot] = index->count++;
+    }
+    return SUCCESS;
+}
+
+/* Compare function used to sort document ids */
+static int compare_id(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int lsh_candidates(LshIndex *index, const unsigned int signature[MINHASH_SIZE], int **ids)
+{
+    int count = 0, capacity = 16;
+    int *found = malloc(capacity * sizeof(int));
+    if (found == NULL)
+        return FAILURE;
+    for (int band = 0; band < LSH_BANDS && index->headCount; band++)
+    {
+        unsigned long long key = band_key(signature, band);
+        for (int e = index->heads[key & (index->headCount - 1)]; e != FAILURE; e = index->entries[e].next)
+        {
+            if (index->entries[e].key != key)
+                continue;
+            if (count == capacity)
+            {
+                int *grown = realloc(found, 2 * capacity * sizeof(int));
+                if (grown == NULL)
+                {
+                    free(found);
+                    return FAILURE;
+                }
+                found = grown;
+                capacity *= 2;
+            }
+            found[count++] = index->entries[e].docId;
+        }
+    }
+
+    // A file sharing several bands is listed once
+    qsort(found, count, sizeof(int), compare_id);
+    int distinct = 0;
+    for (int i = 0; i < count; i++)
+        if (distinct == 0 || found[distinct - 1] != found[i])
+            found[distinct++] = found[i];
+    *ids = found;
+    return distinct;
+}
+
+int lsh_clone(LshIndex *dst, LshIndex *src)
+{
+    lsh_init(dst);
+    if (src->capacity == 0)
+        return SUCCESS;
+    dst->entries = malloc(src->capacity * sizeof(LshEntry));
+    dst->heads = malloc(src->headCount * sizeof(int));
+    if (dst->entries == NULL || dst->heads == NULL)
+    {
+        lsh_free(dst);
+        return FAILURE;
+    }
+    memcpy(dst->entries, src->entries, src->count * sizeof(LshEntry));
+    memcpy(dst->heads, src->heads, src->headCount * sizeof(int));
+    dst->count = src->count;
+    dst->capacity = src->capacity;
+    dst->headCount = src->headCount;
+    return SUCCESS;
+}
+
+void lsh_free(LshIndex *index)
+{
+    free(index->entries);
+    free(index->heads);
+    lsh_init(index);
+}
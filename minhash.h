@@ -0,0 +1,114 @@
+/***********************************************************************
+ *  File name   : minhash.h
+ *  Description : Header file for MinHash signatures and the LSH index
+ *                used to find near-duplicate files in the Inverted
+ *                Search Project.
+ *                A file is seen as the set of its word pairs
+ *                (2-shingles). Its signature keeps, for MINHASH_SIZE
+ *                hash functions, the smallest hash of any shingle; the
+ *                fraction of equal entries of two signatures estimates
+ *                the Jaccard similarity of the files. The LSH index
+ *                cuts each signature into LSH_BANDS bands and files
+ *                sharing a whole band land in the same bucket, so
+ *                candidates are found without comparing against every
+ *                file.
+ *
+ *                Functions:
+ *                - minhash_init()
+ *                - minhash_shingle()
+ *                - minhash_add()
+ *                - minhash_is_empty()
+ *                - minhash_similarity()
+ *                - lsh_init()
+ *                - lsh_insert()
+ *                - lsh_candidates()
+ *                - lsh_clone()
+ *                - lsh_free()
+ *
+ ***********************************************************************/
+
+#ifndef MINHASH_H
+#define MINHASH_H
+
+#include "list.h"
+
+#define MINHASH_SIZE 64                  // Hash functions per signature
+#define LSH_BANDS 16                     // Bands of MINHASH_SIZE / LSH_BANDS rows
+
+/* LshEntry:
+ * A file filed under one band bucket, chained with the other entries
+ * of the same slot.
+ */
+typedef struct LshEntry
+{
+    unsigned long long key;              // Band number and band values
+    int docId;
+    int next;                            // Next entry of the slot, FAILURE at the end
+} LshEntry;
+
+/* LshIndex:
+ * Band buckets of every signed file.
+ */
+typedef struct LshIndex
+{
+    LshEntry *entries;
+    int count;
+    int capacity;
+    int *heads;                          // First entry of each slot, FAILURE if none
+    int headCount;                       // Power of two
+} LshIndex;
+
+/**
+ * Initializes a signature of an empty file.
+ */
+void minhash_init(unsigned int signature[MINHASH_SIZE]);
+
+/**
+ * Returns the shingle hash of the pair (previous word, word) and makes
+ * word the previous one. *previous starts at 0.
+ */
+unsigned long long minhash_shingle(unsigned long long *previous, const char *word);
+
+/**
+ * Adds one shingle to the signature.
+ */
+void minhash_add(unsigned int signature[MINHASH_SIZE], unsigned long long shingle);
+
+/**
+ * Returns 1 if no shingle was added to the signature.
+ */
+int minhash_is_empty(const unsigned int signature[MINHASH_SIZE]);
+
+/**
+ * Returns the estimated Jaccard similarity of two signatures (0 to 1).
+ */
+double minhash_similarity(const unsigned int a[MINHASH_SIZE], const unsigned int b[MINHASH_SIZE]);
+
+/**
+ * Initializes an empty index.
+ */
+void lsh_init(LshIndex *index);
+
+/**
+ * Files docId under every band of its signature. Returns SUCCESS or FAILURE.
+ */
+int lsh_insert(LshIndex *index, int docId, const unsigned int signature[MINHASH_SIZE]);
+
+/**
+ * Stores in *ids (allocated by the call, freed by the caller) the sorted
+ * distinct ids of the files sharing at least one band with signature.
+ * Returns the count, or FAILURE.
+ */
+int lsh_candidates(LshIndex *index, const unsigned int signature[MINHASH_SIZE], int **ids);
+
+/**
+ * Stores a copy of src in dst. Returns SUCCESS or FAILURE.
+ */
+int lsh_clone(LshIndex *dst, LshIndex *src);
+
+/**
+ * Releases the index memory and empties it.
+ */
+void lsh_free(LshIndex *index);
+
+#endif
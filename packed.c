@@ -0,0 +1,778 @@
+/***********************************************************************
+ *  File name   : packed.c
+ *  Description : Implementation file for the compressed (packed)
+ *                database file of the Inverted Search Project.
+ *                Blocks are encoded concurrently, one job item per
+ *                block, and written in order so the file does not
+ *                depend on the number of threads.
+ *
+ *                Functions:
+ *                - save_packed_database()
+ *                - update_database_packed()
+ *                - packedIndex_open()
+ *                - packedIndex_search()
+ *                - packedIndex_close()
+ *
+ ***********************************************************************/
+
+#define _FILE_OFFSET_BITS 64            // 64-bit off_t for files over 2 GiB
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "packed.h"
+#include "validate.h"
+#include "database.h"
+#include "buffer.h"
+#include "parallel.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#define PACKED_ZSTD_LEVEL 3
+#endif
+
+#define PACKED_HEADER_SIZE 48
+#define PACKED_FLAG_ZSTD 1              // Some blocks are zstd compressed
+
+/* ----------- Encoding helpers ----------- */
+
+static void put_varint(TextBuffer *out, unsigned long long value)
+{
+    char bytes[10];
+    int n = 0;
+    while (value >= 0x80)
+    {
+        bytes[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = (char)value;
+    buffer_append(out, bytes, n);
+}
+
+/* Signed values are zigzag encoded: small magnitudes stay short */
+static void put_svarint(TextBuffer *out, long long value)
+{
+    put_varint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+static void put_fixed(TextBuffer *out, unsigned long long value, int size)
+{
+    char bytes[8];
+    for (int i = 0; i < size; i++)
+        bytes[i] = (char)(value >> (8 * i));
+    buffer_append(out, bytes, size);
+}
+
+/* ByteReader:
+ * Bounds-checked reader over a decoded byte range. Reading past the end
+ * sets failed and returns zeros.
+ */
+typedef struct ByteReader
+{
+    const unsigned char *p;
+    const unsigned char *end;
+    int failed;
+} ByteReader;
+
+static unsigned long long get_varint(ByteReader *r)
+{
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (r->p == r->end)
+            break;
+        unsigned char byte = *r->p++;
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+    r->failed = 1;
+    return 0;
+}
+
+static long long get_svarint(ByteReader *r)
+{
+    unsigned long long value = get_varint(r);
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+static unsigned long long get_fixed(const unsigned char *p, int size)
+{
+    unsigned long long value = 0;
+    for (int i = 0; i < size; i++)
+        value |= (unsigned long long)p[i] << (8 * i);
+    return value;
+}
+
+/* Reads a fixed size value, failing past the end */
+static unsigned long long get_fixed_bytes(ByteReader *r, int size)
+{
+    if (r->end - r->p < size)
+    {
+        r->failed = 1;
+        return 0;
+    }
+    unsigned long long value = get_fixed(r->p, size);
+    r->p += size;
+    return value;
+}
+
+/**
+ * Reads a varint length followed by that many bytes into text
+ * (NUL-terminated, at most size - 1 bytes).
+ */
+static void get_text(ByteReader *r, char *text, int size)
+{
+    unsigned long long length = get_varint(r);
+    if (r->failed || length >= (unsigned long long)size || length > (unsigned long long)(r->end - r->p))
+    {
+        r->failed = 1;
+        text[0] = '\0';
+        return;
+    }
+    memcpy(text, r->p, length);
+    text[length] = '\0';
+    r->p += length;
+}
+
+/**
+ * Decodes the next front-coded word of a block into word (which holds
+ * the previous word) and its file count.
+ */
+static void get_term(ByteReader *r, char *word, int *fileCount)
+{
+    unsigned long long shared = get_varint(r);
+    if (r->failed || shared > strlen(word))
+    {
+        r->failed = 1;
+        return;
+    }
+    get_text(r, word + shared, MAX_WORD_LENGTH - (int)shared);
+    unsigned long long count = get_varint(r);
+    if (count > 0x7FFFFFFF)
+        r->failed = 1;
+    *fileCount = (int)count;
+}
+
+/* ----------- Saving ----------- */
+
+/* PackJob:
+ * Shared by the block workers of save_packed_database().
+ */
+typedef struct PackJob
+{
+    MainNode **terms;          // Every word, sorted
+    int termCount;
+    TextBuffer *blocks;        // Stored bytes of each block
+    unsigned int *rawSizes;    // Size of each block before compression
+} PackJob;
+
+/* PostingPair:
+ * A document id and word count, sorted before gap coding.
+ */
+typedef struct PostingPair
+{
+    int docId;
+    int wordCount;
+} PostingPair;
+
+/* Compare function used to sort postings by document id */
+static int compare_pair(const void *a, const void *b)
+{
+    const PostingPair *x = a, *y = b;
+    return (x->docId > y->docId) - (x->docId < y->docId);
+}
+
+/* Encodes one block: for every word the shared prefix length, the
+ * suffix, the file count and the (id gap, count) pairs */
+static int pack_block(int block, void *arg)
+{
+    PackJob *job = arg;
+    int first = block * PACKED_BLOCK_TERMS;
+    int last = first + PACKED_BLOCK_TERMS < job->termCount ? first + PACKED_BLOCK_TERMS : job->termCount;
+    TextBuffer raw;
+    buffer_init(&raw);
+
+    PostingPair *pairs = NULL;
+    int pairCapacity = 0;
+    const char *prev = "";
+    for (int t = first; t < last; t++)
+    {
+        MainNode *node = job->terms[t];
+        int shared = 0;
+        while (prev[shared] && prev[shared] == node->word[shared])
+            shared++;
+        int suffix = (int)strlen(node->word + shared);
+        put_varint(&raw, shared);
+        put_varint(&raw, suffix);
+        buffer_append(&raw, node->word + shared, suffix);
+        prev = node->word;
+
+        if (node->fileCount > pairCapacity)
+        {
+            PostingPair *grown = realloc(pairs, node->fileCount * sizeof(PostingPair));
+            if (grown == NULL)
+            {
+                free(pairs);
+                buffer_free(&raw);
+                return FAILURE;
+            }
+            pairs = grown;
+            pairCapacity = node->fileCount;
+        }
+        PostingCursor cursor;
+        int count = 0, sorted = 1;
+        postingCursor_init(&cursor, node);
+        while (count < node->fileCount && postingCursor_next(&cursor, &pairs[count].docId, &pairs[count].wordCount))
+        {
+            sorted &= count == 0 || pairs[count - 1].docId <= pairs[count].docId;
+            count++;
+        }
+        if (!sorted)
+            qsort(pairs, count, sizeof(PostingPair), compare_pair);
+
+        put_varint(&raw, count);
+        for (int i = 0; i < count; i++)
+        {
+            put_varint(&raw, pairs[i].docId - (i ? pairs[i - 1].docId : 0));
+            put_varint(&raw, pairs[i].wordCount);
+        }
+    }
+    free(pairs);
+    if (raw.failed)
+    {
+        buffer_free(&raw);
+        return FAILURE;
+    }
+    job->rawSizes[block] = (unsigned int)raw.length;
+
+#ifdef HAVE_ZSTD
+    // Keep the compressed form only when it is smaller
+    size_t bound = ZSTD_compressBound(raw.length);
+    TextBuffer *out = &job->blocks[block];
+    char *packed = malloc(bound);
+    if (packed)
+    {
+        size_t size = ZSTD_compress(packed, bound, raw.data, raw.length, PACKED_ZSTD_LEVEL);
+        if (!ZSTD_isError(size) && size < raw.length)
+        {
+            buffer_append(out, packed, size);
+            free(packed);
+            buffer_free(&raw);
+            return out->failed ? FAILURE : SUCCESS;
+        }
+        free(packed);
+    }
+#endif
+    job->blocks[block] = raw;
+    return SUCCESS;
+}
+
+/**
+ * Sorts every word, encodes the blocks in parallel and writes header,
+ * document table, blocks and block index.
+ */
+int save_packed_database(HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, char *path)
+{
+    PackJob job;
+    int termCount;
+    if (hashTable_sorted_terms(hashTablle, "", "", -1, &job.terms, &termCount) == FAILURE)
+        return FAILURE;
+    int blockCount = (termCount + PACKED_BLOCK_TERMS - 1) / PACKED_BLOCK_TERMS;
+
+    job.blocks = malloc((blockCount + 1) * sizeof(TextBuffer));
+    job.rawSizes = malloc((blockCount + 1) * sizeof(unsigned int));
+    job.termCount = termCount;
+    if (job.blocks == NULL || job.rawSizes == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not allocate memory to save the Database\n");
+        free(job.terms);
+        free(job.blocks);
+        free(job.rawSizes);
+        return FAILURE;
+    }
+    for (int b = 0; b < blockCount; b++)
+        buffer_init(&job.blocks[b]);
+
+    int status = parallel_for(blockCount, get_thread_count(), pack_block, &job);
+
+    // Document table and block index
+    TextBuffer head, index;
+    buffer_init(&head);
+    buffer_init(&index);
+    for (int d = 0; d < docs->count; d++)
+    {
+        put_varint(&head, strlen(docs->names[d]));
+        buffer_append_str(&head, docs->names[d]);
+        put_varint(&head, (unsigned long long)(docs->sizes[d] + 1));
+        put_svarint(&head, docs->mtimes[d]);
+        put_varint(&head, (unsigned long long)(docs->tokenCounts[d] + 1));
+        int hasSignature = !minhash_is_empty(docs->signatures[d]);
+        put_varint(&head, hasSignature);
+        for (int k = 0; hasSignature && k < MINHASH_SIZE; k++)
+            put_fixed(&head, docs->signatures[d][k], 4);
+    }
+    unsigned long long blockOffset = PACKED_HEADER_SIZE + head.length;
+    unsigned long long offset = blockOffset;
+    int compressed = 0;
+    for (int b = 0; b < blockCount && status == SUCCESS; b++)
+    {
+        const char *firstWord = job.terms[b * PACKED_BLOCK_TERMS]->word;
+        int terms = b == blockCount - 1 ? termCount - b * PACKED_BLOCK_TERMS : PACKED_BLOCK_TERMS;
+        put_varint(&index, offset);
+        put_varint(&index, job.blocks[b].length);
+        put_varint(&index, job.rawSizes[b]);
+        put_varint(&index, terms);
+        put_varint(&index, strlen(firstWord));
+        buffer_append_str(&index, firstWord);
+        offset += job.blocks[b].length;
+        compressed |= job.blocks[b].length != job.rawSizes[b];
+    }
+
+    TextBuffer header;
+    buffer_init(&header);
+    buffer_append(&header, PACKED_MAGIC, 4);
+    put_fixed(&header, PACKED_VERSION, 4);
+    put_fixed(&header, docs->count, 4);
+    put_fixed(&header, termCount, 4);
+    put_fixed(&header, blockCount, 4);
+    put_fixed(&header, compressed ? PACKED_FLAG_ZSTD : 0, 4);
+    put_fixed(&header, PACKED_HEADER_SIZE, 8);
+    put_fixed(&header, blockOffset, 8);
+    put_fixed(&header, offset, 8);
+    if (head.failed || index.failed || header.failed)
+        status = FAILURE;
+
+    FILE *fp = NULL;
+    if (status == FAILURE)
+        fprintf(stderr, "ERROR: Could not allocate memory to save the Database\n");
+    else if ((fp = fopen(path, "wb")) == NULL)
+    {
+        fprintf(stderr, "Packed FILE with name %s Could not be created\n", path);
+        status = FAILURE;
+    }
+    else
+    {
+        if (fwrite(header.data, 1, header.length, fp) != header.length ||
+            (head.length && fwrite(head.data, 1, head.length, fp) != head.length))
+            status = FAILURE;
+        for (int b = 0; b < blockCount && status == SUCCESS; b++)
+        {
+            TextBuffer *block = &job.blocks[b];
+            if (block->length && fwrite(block->data, 1, block->length, fp) != block->length)
+                status = FAILURE;
+        }
+        if (index.length && fwrite(index.data, 1, index.length, fp) != index.length)
+            status = FAILURE;
+        if (fclose(fp) != 0 || status == FAILURE)
+        {
+            fprintf(stderr, "ERROR: Could not write Packed FILE %s\n", path);
+            status = FAILURE;
+        }
+    }
+
+    if (status == SUCCESS)
+        printf("\nINFO: Database saved in packed file %s (%d words in %d blocks, %llu bytes)\n",
+               path, termCount, blockCount, offset + index.length);
+    for (int b = 0; b < blockCount; b++)
+        buffer_free(&job.blocks[b]);
+    buffer_free(&header);
+    buffer_free(&head);
+    buffer_free(&index);
+    free(job.terms);
+    free(job.blocks);
+    free(job.rawSizes);
+    return status;
+}
+
+/* ----------- Reading ----------- */
+
+/**
+ * Reads size bytes at offset into a new allocation, or returns NULL.
+ */
+static unsigned char *read_range(FILE *fp, unsigned long long offset, size_t size)
+{
+    unsigned char *data = malloc(size + 1);
+    if (data == NULL)
+        return NULL;
+    if ((off_t)offset < 0 || fseeko(fp, (off_t)offset, SEEK_SET) != 0 || fread(data, 1, size, fp) != size)
+    {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+/**
+ * Reads the header, the document table and the block index.
+ */
+int packedIndex_open(PackedIndex *index, char *path)
+{
+    index->names = NULL;
+    index->sizes = index->mtimes = NULL;
+    index->tokenCounts = NULL;
+    index->signatures = NULL;
+    index->blocks = NULL;
+    index->cache = NULL;
+    index->cachedBlock = FAILURE;
+    index->docCount = index->blockCount = 0;
+    if ((index->fp = fopen(path, "rb")) == NULL)
+    {
+        fprintf(stderr, " ERROR: %s file could not be opened\n", path);
+        return FAILURE;
+    }
+
+    unsigned char header[PACKED_HEADER_SIZE];
+    struct stat info;
+    unsigned long long fileSize = fstat(fileno(index->fp), &info) == 0 ? (unsigned long long)info.st_size : 0;
+    unsigned long long version = 0;
+    if (fread(header, 1, PACKED_HEADER_SIZE, index->fp) != PACKED_HEADER_SIZE || memcmp(header, PACKED_MAGIC, 4) != 0 ||
+        (version = get_fixed(header + 4, 4)) < PACKED_MIN_VERSION || version > PACKED_VERSION)
+    {
+        fprintf(stderr, " ERROR: %s file is not a packed DATABASE file\n", path);
+        packedIndex_close(index);
+        return FAILURE;
+    }
+    unsigned long long docCount = get_fixed(header + 8, 4), blockCount = get_fixed(header + 16, 4);
+    unsigned long long docOffset = get_fixed(header + 24, 8);
+    unsigned long long blockOffset = get_fixed(header + 32, 8);
+    unsigned long long indexOffset = get_fixed(header + 40, 8);
+#ifndef HAVE_ZSTD
+    if (get_fixed(header + 20, 4) & PACKED_FLAG_ZSTD)
+    {
+        fprintf(stderr, " ERROR: %s needs zstd support (build with -DHAVE_ZSTD -lzstd)\n", path);
+        packedIndex_close(index);
+        return FAILURE;
+    }
+#endif
+    if (docOffset > blockOffset || blockOffset > indexOffset || indexOffset > fileSize ||
+        docCount > fileSize || blockCount > fileSize)
+    {
+        fprintf(stderr, " ERROR: %s packed file is corrupted\n", path);
+        packedIndex_close(index);
+        return FAILURE;
+    }
+
+    unsigned char *docData = read_range(index->fp, docOffset, blockOffset - docOffset);
+    unsigned char *indexData = read_range(index->fp, indexOffset, fileSize - indexOffset);
+    index->names = malloc((docCount + 1) * sizeof(*index->names));
+    index->sizes = malloc((docCount + 1) * sizeof(long long));
+    index->mtimes = malloc((docCount + 1) * sizeof(long long));
+    index->tokenCounts = malloc((docCount + 1) * sizeof(int));
+    index->signatures = malloc((docCount + 1) * sizeof(*index->signatures));
+    index->blocks = malloc((blockCount + 1) * sizeof(PackedBlock));
+    ByteReader docs = { docData, docData + (blockOffset - docOffset), docData == NULL };
+    ByteReader blocks = { indexData, indexData + (fileSize - indexOffset), indexData == NULL };
+    int allocated = index->names && index->sizes && index->mtimes && index->tokenCounts && index->signatures && index->blocks;
+    if (allocated)
+    {
+        for (unsigned long long d = 0; d < docCount; d++)
+        {
+            get_text(&docs, index->names[d], MAX_FILENAME_LENGTH);
+            // Version 1 files have no metadata
+            index->sizes[d] = version > 1 ? (long long)get_varint(&docs) - 1 : DOC_UNKNOWN;
+            index->mtimes[d] = version > 1 ? get_svarint(&docs) : DOC_UNKNOWN_TIME;
+            index->tokenCounts[d] = version > 1 ? (int)get_varint(&docs) - 1 : DOC_UNKNOWN;
+            // Version 2 files have no signatures
+            minhash_init(index->signatures[d]);
+            if (version > 2 && get_varint(&docs))
+                for (int k = 0; k < MINHASH_SIZE; k++)
+                    index->signatures[d][k] = (unsigned int)get_fixed_bytes(&docs, 4);
+        }
+        for (unsigned long long b = 0; b < blockCount; b++)
+        {
+            PackedBlock *block = &index->blocks[b];
+            block->offset = get_varint(&blocks);
+            block->storedSize = (unsigned int)get_varint(&blocks);
+            block->rawSize = (unsigned int)get_varint(&blocks);
+            block->termCount = (int)get_varint(&blocks);
+            get_text(&blocks, block->firstWord, MAX_WORD_LENGTH);
+            if (block->offset < blockOffset || block->offset + block->storedSize > indexOffset)
+                blocks.failed = 1;
+        }
+    }
+    free(docData);
+    free(indexData);
+    if (!allocated || docs.failed || blocks.failed)
+    {
+        fprintf(stderr, " ERROR: %s packed file could not be read\n", path);
+        packedIndex_close(index);
+        return FAILURE;
+    }
+    index->docCount = (int)docCount;
+    index->blockCount = (int)blockCount;
+    return SUCCESS;
+}
+
+/**
+ * Returns the decoded bytes of a block, reading it unless it is the
+ * cached one. Returns NULL on error.
+ */
+static unsigned char *load_block(PackedIndex *index, int b)
+{
+    if (index->cachedBlock == b)
+        return index->cache;
+    PackedBlock *block = &index->blocks[b];
+    unsigned char *stored = read_range(index->fp, block->offset, block->storedSize);
+    if (stored == NULL)
+        return NULL;
+    unsigned char *raw = stored;
+    if (block->storedSize != block->rawSize)
+    {
+#ifdef HAVE_ZSTD
+        raw = malloc(block->rawSize + 1);
+        if (raw && ZSTD_decompress(raw, block->rawSize, stored, block->storedSize) != block->rawSize)
+        {
+            free(raw);
+            raw = NULL;
+        }
+#else
+        raw = NULL;
+#endif
+        free(stored);
+        if (raw == NULL)
+            return NULL;
+    }
+    free(index->cache);
+    index->cache = raw;
+    index->cachedBlock = b;
+    return raw;
+}
+
+/**
+ * Returns the block that would hold word (the last block whose first
+ * word is not greater), or FAILURE.
+ */
+static int find_block(PackedIndex *index, char *word)
+{
+    int lo = 0, hi = index->blockCount - 1, found = FAILURE;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (strcmp(index->blocks[mid].firstWord, word) <= 0)
+        {
+            found = mid;
+            lo = mid + 1;
+        }
+        else
+            hi = mid - 1;
+    }
+    return found;
+}
+
+/**
+ * Scans the front-coded words of a single block.
+ */
+void packedIndex_search(PackedIndex *index, char *word)
+{
+    int b = find_block(index, word);
+    unsigned char *data = b == FAILURE ? NULL : load_block(index, b);
+    if (b != FAILURE && data == NULL)
+    {
+        fprintf(stderr, "\nERROR: Could not read block %d of the packed file\n", b);
+        return;
+    }
+
+    ByteReader r = { data, data + (data ? index->blocks[b].rawSize : 0), 0 };
+    char term[MAX_WORD_LENGTH] = "";
+    for (int t = 0; data && t < index->blocks[b].termCount && !r.failed; t++)
+    {
+        int fileCount;
+        get_term(&r, term, &fileCount);
+        int cmp = strcmp(term, word);
+        if (cmp > 0)
+            break;
+        if (cmp < 0)
+        {
+            for (int i = 0; i < 2 * fileCount && !r.failed; i++)
+                get_varint(&r);
+            continue;
+        }
+
+        printf("\nWord '%s' is present in (%d) file\n", term, fileCount);
+        int docId = 0;
+        for (int i = 0; i < fileCount && !r.failed; i++)
+        {
+            docId += (int)get_varint(&r);
+            int wordCount = (int)get_varint(&r);
+            if (r.failed || docId >= index->docCount)
+                break;
+            printf("In File : '%s' (%d) Time\n", index->names[docId], wordCount);
+        }
+        return;
+    }
+    if (r.failed)
+        fprintf(stderr, "\nERROR: Block %d of the packed file is corrupted\n", b);
+    else
+        printf("\nWord \"%s\" not present in the DATABASE\n", word);
+}
+
+void packedIndex_close(PackedIndex *index)
+{
+    if (index->fp)
+        fclose(index->fp);
+    free(index->names);
+    free(index->sizes);
+    free(index->mtimes);
+    free(index->tokenCounts);
+    free(index->signatures);
+    free(index->blocks);
+    free(index->cache);
+    index->fp = NULL;
+    index->names = NULL;
+    index->sizes = index->mtimes = NULL;
+    index->tokenCounts = NULL;
+    index->signatures = NULL;
+    index->blocks = NULL;
+    index->cache = NULL;
+    index->cachedBlock = FAILURE;
+}
+
+/* ----------- Loading ----------- */
+
+/**
+ * Decodes one block into MainNodes linked into the hash table; a word
+ * the table already has gets the new files merged into its node.
+ * docIds maps packed document ids to ids of docs. Every term is decoded
+ * and its bucket reserved before the first one is linked, so a failing
+ * block leaves the table unchanged unless growing the dense postings
+ * of an existing word fails.
+ */
+static int unpack_block(PackedIndex *index, int b, int *docIds, HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, TermSketch *sketch)
+{
+    unsigned char *data = load_block(index, b);
+    if (data == NULL)
+        return FAILURE;
+    int termCount = index->blocks[b].termCount;
+    MainNode **nodes = calloc(termCount + 1, sizeof(MainNode *));
+    MainNode **targets = calloc(termCount + 1, sizeof(MainNode *));
+    long long *totals = malloc((termCount + 1) * sizeof(long long));
+    int status = nodes && targets && totals ? SUCCESS : FAILURE;
+    int added[MAX_HASH_SIZE] = {0};
+
+    ByteReader r = { data, data + index->blocks[b].rawSize, 0 };
+    char term[MAX_WORD_LENGTH] = "";
+    for (int t = 0; t < termCount && status == SUCCESS; t++)
+    {
+        int fileCount;
+        get_term(&r, term, &fileCount);
+        int bucket = get_word_index(term);
+        MainNode *newMain = r.failed || bucket < 0 || bucket >= MAX_HASH_SIZE ? NULL : create_mainNode(term, fileCount);
+        if ((nodes[t] = newMain) == NULL)
+        {
+            status = FAILURE;
+            break;
+        }
+        if ((targets[t] = termTable_find(&hashTablle[bucket].terms, term)) == NULL)
+            added[bucket]++;
+
+        SubNode *temp_s = NULL;
+        int packedId = 0;
+        totals[t] = 0;
+        for (int i = 0; i < fileCount; i++)
+        {
+            packedId += (int)get_varint(&r);
+            int wordCount = (int)get_varint(&r);
+            totals[t] += wordCount;
+            SubNode *newSub = NULL;
+            if (!r.failed && packedId >= 0 && packedId < index->docCount)
+                newSub = create_subNode(docs->names[docIds[packedId]], docIds[packedId], wordCount);
+            if (newSub == NULL)
+            {
+                status = FAILURE;
+                break;
+            }
+            if (temp_s)
+                temp_s->subLink = newSub;
+            else
+                newMain->subLink = newSub;
+            temp_s = newSub;
+        }
+        if (status == FAILURE || targets[t])
+            continue;
+        // Ids of files the table already had need not follow the packed order
+        mainNode_sort_postings(newMain);
+        if (newMain->fileCount > DENSE_POSTING_THRESHOLD && mainNode_make_dense(newMain) == FAILURE)
+            status = FAILURE;
+    }
+
+    for (int t = 0; t < termCount && status == SUCCESS && sketch; t++)
+        status = termSketch_add(sketch, nodes[t]->word, totals[t]);
+
+    // Linking cannot fail once every bucket has room for its new terms
+    for (int i = 0; i < MAX_HASH_SIZE && status == SUCCESS; i++)
+        if (added[i] && termTable_reserve(&hashTablle[i].terms, hashTablle[i].terms.size + added[i]) == FAILURE)
+            status = FAILURE;
+    for (int t = 0; t < termCount && status == SUCCESS; t++)
+    {
+        MainNode *node = nodes[t];
+        nodes[t] = NULL;
+        if (targets[t])
+            status = mainNode_merge(targets[t], node);
+        else if (hashTable_link_mainNode(hashTablle, get_word_index(node->word), node) == FAILURE)
+        {
+            nodes[t] = node;
+            status = FAILURE;
+        }
+    }
+
+    for (int t = 0; nodes && t < termCount; t++)
+        if (nodes[t])
+            free_mainNode(nodes[t]);
+    free(nodes);
+    free(targets);
+    free(totals);
+    return status;
+}
+
+/* Update database from a packed file and merge with new file list.
+ * On FAILURE the tables may hold part of the file and must be discarded. */
+int update_database_packed(FileList **filelist, HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, TermSketch *sketch, char *path)
+{
+    PackedIndex index;
+    if (packedIndex_open(&index, path) == FAILURE)
+        return FAILURE;
+
+    int status = SUCCESS;
+    int *docIds = malloc((index.docCount + 1) * sizeof(int));
+    if (docIds == NULL)
+        status = FAILURE;
+    for (int d = 0; d < index.docCount && status == SUCCESS; d++)
+    {
+        if ((docIds[d] = docTable_get_id(docs, index.names[d])) == FAILURE)
+            status = FAILURE;
+        // Metadata and signatures of files the table already knew are kept
+        else if (docs->tokenCounts[docIds[d]] == DOC_UNKNOWN)
+            docTable_set_metadata(docs, docIds[d], index.sizes[d], index.mtimes[d], index.tokenCounts[d]);
+        if (status == SUCCESS && minhash_is_empty(docs->signatures[docIds[d]]) && !minhash_is_empty(index.signatures[d]) &&
+            docTable_set_signature(docs, docIds[d], index.signatures[d]) == FAILURE)
+            fprintf(stderr, "INFO: Could not index the signature of file %s\n", index.names[d]);
+    }
+    for (int b = 0; b < index.blockCount && status == SUCCESS; b++)
+        status = unpack_block(&index, b, docIds, hashTablle, docs, sketch);
+    // The packed files leave the FileList only once they are all loaded
+    for (int d = 0; d < index.docCount && status == SUCCESS; d++)
+    {
+        if (delete_duplicate(filelist, index.names[d]) == SUCCESS)
+        {
+            printf("\nINFO: Deleting File %s in FileList (already present in the database file %s)\n", index.names[d], path);
+            print_fileList(*filelist);
+        }
+    }
+    free(docIds);
+    packedIndex_close(&index);
+
+    if (status == FAILURE)
+    {
+        fprintf(stderr, "\n ERROR: Could not create Database\n");
+        return FAILURE;
+    }
+    // Every input file may already be in the packed file
+    if (*filelist && create_database(*filelist, hashTablle, docs, sketch) == FAILURE)
+    {
+        printf("\nINFO: Database could not be Updated\n");
+        return FAILURE;
+    }
+    printf("\nINFO: Database Successfully Updated\n");
+    return SUCCESS;
+}
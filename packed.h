@@ -0,0 +1,113 @@
+/***********************************************************************
+ *  File name   : packed.h
+ *  Description : Header file for the compressed (packed) database file
+ *                of the Inverted Search Project.
+ *                Unlike the text backup, file names are stored once in
+ *                a document table and referenced by id. Words are sorted
+ *                and cut into blocks of PACKED_BLOCK_TERMS; inside a block
+ *                every word keeps only the suffix it does not share with
+ *                the previous one (front coding), and document ids (as
+ *                gaps) and word counts are written as varints. A block
+ *                index at the end of the file holds the first word and
+ *                position of every block, so a search reads and decodes
+ *                a single block. Blocks are zstd compressed when built
+ *                with -DHAVE_ZSTD -lzstd. Version 1 files (without
+ *                file metadata) and version 2 files (without
+ *                signatures) are still read.
+ *
+ *                Layout (integers little-endian):
+ *                  header   "ISPK", version, docCount, termCount,
+ *                           blockCount, flags, docOffset, blockOffset,
+ *                           indexOffset
+ *                  docs     varint length + name, then (version 2)
+ *                           size + 1, zigzag mtime and tokens + 1 as
+ *                           varints (0 / DOC_UNKNOWN_TIME if unknown),
+ *                           then (version 3) varint 1 and the MinHash
+ *                           signature as MINHASH_SIZE 4-byte values, or
+ *                           varint 0 without one, docCount times
+ *                  blocks   encoded terms
+ *                  index    varint offset, stored size, raw size,
+ *                           term count, first word length + first word
+ *
+ *                Functions:
+ *                - save_packed_database()
+ *                - update_database_packed()
+ *                - packedIndex_open()
+ *                - packedIndex_search()
+ *                - packedIndex_close()
+ *
+ ***********************************************************************/
+
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "list.h"
+#include "docs.h"
+#include "stats.h"
+
+#define PACKED_MAGIC "ISPK"
+#define PACKED_VERSION 3
+#define PACKED_MIN_VERSION 1            // Oldest version still read
+#define PACKED_BLOCK_TERMS 128          // Words per block
+
+/* PackedBlock:
+ * Block index entry.
+ */
+typedef struct PackedBlock
+{
+    unsigned long long offset;          // Position of the block in the file
+    unsigned int storedSize;            // Bytes in the file
+    unsigned int rawSize;               // Bytes once decompressed
+    int termCount;
+    char firstWord[MAX_WORD_LENGTH];
+} PackedBlock;
+
+/* PackedIndex:
+ * An open packed file. Only the document table and the block index are
+ * kept in memory; the last decoded block is cached.
+ */
+typedef struct PackedIndex
+{
+    FILE *fp;
+    char (*names)[MAX_FILENAME_LENGTH];
+    long long *sizes;                   // File metadata, DOC_UNKNOWN(_TIME) if not stored
+    long long *mtimes;
+    int *tokenCounts;
+    unsigned int (*signatures)[MINHASH_SIZE];   // Empty if not stored
+    int docCount;
+    int blockCount;
+    PackedBlock *blocks;
+    int cachedBlock;                    // Index of the block in cache, FAILURE if none
+    unsigned char *cache;
+} PackedIndex;
+
+/**
+ * Writes the database to a packed file. Returns SUCCESS or FAILURE.
+ */
+int save_packed_database(HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, char *path);
+
+/**
+ * Loads a packed file into the database like update_database(), then
+ * indexes the remaining files of filelist. Returns SUCCESS, or FAILURE,
+ * after which the tables may hold part of the update.
+ */
+int update_database_packed(FileList **filelist, HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, TermSketch *sketch, char *path);
+
+/**
+ * Opens a packed file, reading its document table and block index.
+ * Returns SUCCESS or FAILURE.
+ */
+int packedIndex_open(PackedIndex *index, char *path);
+
+/**
+ * Prints the files containing word, decoding only the block it would
+ * be stored in.
+ */
+void packedIndex_search(PackedIndex *index, char *word);
+
+/**
+ * Closes the file and frees the in-memory tables.
+ */
+void packedIndex_close(PackedIndex *index);
+
+#endif
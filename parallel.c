@@ -0,0 +1,93 @@
+/***********************************************************************
+ *  File name   : parallel.c
+ *  Description : Implementation file for the thread pool helper of the
+ *                Inverted Search Project (POSIX threads).
+ *
+ *                Functions:
+ *                - get_thread_count()
+ *                - parallel_for()
+ *
+ ***********************************************************************/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "parallel.h"
+#include "list.h"
+
+/* ParallelJob:
+ * Shared state of one parallel_for() call.
+ */
+typedef struct ParallelJob
+{
+    int count;                     // Number of items
+    atomic_int next;               // Next item to hand out
+    atomic_int failed;             // Set when a work call returns FAILURE
+    int (*work)(int item, void *arg);
+    void *arg;
+} ParallelJob;
+
+/**
+ * Returns the thread count from THREADS_ENV or the CPU count.
+ */
+int get_thread_count(void)
+{
+    int threads = 0;
+    char *env = getenv(THREADS_ENV);
+    if (env != NULL)
+        threads = atoi(env);
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+    return threads > MAX_THREADS ? MAX_THREADS : threads;
+}
+
+/**
+ * Worker loop: claims items until none are left.
+ */
+static void *parallel_worker(void *data)
+{
+    ParallelJob *job = data;
+    int item;
+    while ((item = atomic_fetch_add(&job->next, 1)) < job->count)
+    {
+        if (job->work(item, job->arg) == FAILURE)
+            atomic_store(&job->failed, 1);
+    }
+    return NULL;
+}
+
+/**
+ * Runs the items on the calling thread plus threads - 1 workers.
+ */
+int parallel_for(int count, int threads, int (*work)(int item, void *arg), void *arg)
+{
+    ParallelJob job;
+    job.count = count;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+    job.work = work;
+    job.arg = arg;
+
+    if (threads > count)
+        threads = count;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    pthread_t workers[MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+    {
+        if (pthread_create(&workers[started], NULL, parallel_worker, &job) != 0)
+            break;          // Fewer threads, same result
+        started++;
+    }
+
+    parallel_worker(&job);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+
+    return atomic_load(&job.failed) ? FAILURE : SUCCESS;
+}
@@ -0,0 +1,35 @@
+/***********************************************************************
+ *  File name   : parallel.h
+ *  Description : Header file for the small thread pool helper of the
+ *                Inverted Search Project.
+ *                Work is split into independent items (usually hash
+ *                table buckets). Items are handed out to worker threads
+ *                one at a time; callers keep one result slot per item,
+ *                so results do not depend on the number of threads.
+ *
+ *                Functions:
+ *                - get_thread_count()
+ *                - parallel_for()
+ *
+ ***********************************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#define MAX_THREADS 16                          // Upper bound on worker threads
+#define THREADS_ENV "INVERTED_SEARCH_THREADS"   // Environment override of the thread count
+
+/**
+ * Returns the number of worker threads to use: THREADS_ENV if set,
+ * otherwise the number of online CPUs, capped at MAX_THREADS.
+ */
+int get_thread_count(void);
+
+/**
+ * Calls work(item, arg) for every item in [0, count) using up to
+ * threads threads. Returns once every item is done.
+ * Returns SUCCESS, or FAILURE if any call returned FAILURE.
+ */
+int parallel_for(int count, int threads, int (*work)(int item, void *arg), void *arg);
+
+#endif
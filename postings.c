@@ -0,0 +1,379 @@
+/***********************************************************************
+ *  File name   : postings.c
+ *  Description : Implementation file for posting list kernels of the
+ *                Inverted Search Project.
+ *                - Scalar merge intersection/union
+ *                - Galloping (exponential search) intersection for
+ *                  lists of very different lengths
+ *                - SSE4.1 and AVX2 block intersection: a block of ids
+ *                  from one list is compared against every rotation of
+ *                  a block from the other list
+ *                - SSE4.1 union: a min/max merging network produces
+ *                  4 sorted ids per step, duplicates are dropped while
+ *                  storing
+ *                The SIMD kernels are compiled with target attributes
+ *                and selected at run time, so the binary still runs on
+ *                CPUs without them.
+ *
+ *                Functions:
+ *                - postings_simd_level()
+ *                - postings_intersect()
+ *                - postings_union()
+ *                - postings_intersect_scalar()
+ *                - postings_intersect_galloping()
+ *                - postings_intersect_sse41()
+ *                - postings_intersect_avx2()
+ *                - postings_union_scalar()
+ *                - postings_union_sse41()
+ *
+ ***********************************************************************/
+
+#include "postings.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POSTINGS_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Detects SSE4.1/AVX2 once and caches the answer.
+ */
+int postings_simd_level(void)
+{
+    static int level = -1;
+    if (level < 0)
+    {
+        int detected = POSTINGS_SIMD_NONE;
+#ifdef POSTINGS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            detected = POSTINGS_SIMD_AVX2;
+        else if (__builtin_cpu_supports("sse4.1"))
+            detected = POSTINGS_SIMD_SSE41;
+#endif
+        level = detected;
+    }
+    return level;
+}
+
+/**
+ * Picks galloping for skewed sizes, otherwise the best block kernel.
+ */
+int postings_intersect(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    if ((long)na * POSTINGS_GALLOP_RATIO < nb || (long)nb * POSTINGS_GALLOP_RATIO < na)
+        return postings_intersect_galloping(a, na, b, nb, out);
+
+    switch (postings_simd_level())
+    {
+        case POSTINGS_SIMD_AVX2:
+            return postings_intersect_avx2(a, na, b, nb, out);
+        case POSTINGS_SIMD_SSE41:
+            return postings_intersect_sse41(a, na, b, nb, out);
+        default:
+            return postings_intersect_scalar(a, na, b, nb, out);
+    }
+}
+
+/**
+ * Uses the SSE4.1 merging network for lists of similar length. For
+ * skewed lists the scalar merge mostly copies the long list and wins.
+ */
+int postings_union(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    int skewed = (long)na * POSTINGS_GALLOP_RATIO < nb || (long)nb * POSTINGS_GALLOP_RATIO < na;
+    if (!skewed && postings_simd_level() >= POSTINGS_SIMD_SSE41)
+        return postings_union_sse41(a, na, b, nb, out);
+    return postings_union_scalar(a, na, b, nb, out);
+}
+
+/**
+ * Classic two-pointer merge intersection.
+ */
+int postings_intersect_scalar(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+            i++;
+        else if (a[i] > b[j])
+            j++;
+        else
+        {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+/**
+ * For each id of the shorter list, gallops forward in the longer
+ * list and finishes with a binary search.
+ */
+int postings_intersect_galloping(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    // Always probe the longer list with ids from the shorter one
+    if (na > nb)
+    {
+        const unsigned int *t = a; a = b; b = t;
+        int tn = na; na = nb; nb = tn;
+    }
+
+    int pos = 0, n = 0;
+    for (int i = 0; i < na && pos < nb; i++)
+    {
+        unsigned int x = a[i];
+        if (b[pos] < x)
+        {
+            // Exponential search for a range (lo, hi] holding the first id >= x
+            int lo = pos, step = 1;
+            while (lo + step < nb && b[lo + step] < x)
+            {
+                lo += step;
+                step *= 2;
+            }
+            int hi = lo + step < nb ? lo + step : nb;
+            while (lo + 1 < hi)
+            {
+                int mid = lo + (hi - lo) / 2;
+                if (b[mid] < x)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            pos = hi;
+            if (pos == nb)
+                break;
+        }
+        if (b[pos] == x)
+            out[n++] = x;
+    }
+    return n;
+}
+
+/**
+ * Two-pointer merge union, an id present in both lists is stored once.
+ */
+int postings_union_scalar(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+            out[n++] = a[i++];
+        else if (a[i] > b[j])
+            out[n++] = b[j++];
+        else
+        {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    while (i < na)
+        out[n++] = a[i++];
+    while (j < nb)
+        out[n++] = b[j++];
+    return n;
+}
+
+#ifdef POSTINGS_X86
+
+/**
+ * 4x4 block intersection. Every id of the a block is compared with
+ * the four rotations of the b block; the block with the smaller
+ * maximum is then consumed.
+ */
+__attribute__((target("sse4.1")))
+int postings_intersect_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    int i = 0, j = 0, n = 0;
+    while (i + 4 <= na && j + 4 <= nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+
+        __m128i hit = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, vb));
+
+        unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(hit));
+        while (mask)
+        {
+            out[n++] = a[i + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+
+        unsigned int amax = a[i + 3], bmax = b[j + 3];
+        if (amax <= bmax)
+            i += 4;
+        if (bmax <= amax)
+            j += 4;
+    }
+    return n + postings_intersect_scalar(a + i, na - i, b + j, nb - j, out + n);
+}
+
+/**
+ * 8x8 block intersection, same scheme as the SSE4.1 kernel.
+ */
+__attribute__((target("avx2")))
+int postings_intersect_avx2(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    int i = 0, j = 0, n = 0;
+    while (i + 8 <= na && j + 8 <= nb)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+
+        __m256i hit = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; r++)
+        {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(va, vb));
+        }
+
+        unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        while (mask)
+        {
+            out[n++] = a[i + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+
+        unsigned int amax = a[i + 7], bmax = b[j + 7];
+        if (amax <= bmax)
+            i += 8;
+        if (bmax <= amax)
+            j += 8;
+    }
+    return n + postings_intersect_sse41(a + i, na - i, b + j, nb - j, out + n);
+}
+
+/**
+ * Merges two sorted vectors: lo receives the 4 smallest ids and
+ * hi the 4 largest, both in ascending order.
+ */
+__attribute__((target("sse4.1")))
+static inline void merge_network(__m128i x, __m128i y, __m128i *lo, __m128i *hi)
+{
+    __m128i low = _mm_min_epu32(x, y);
+    __m128i high = _mm_max_epu32(x, y);
+    for (int r = 0; r < 3; r++)
+    {
+        low = _mm_alignr_epi8(low, low, 4);
+        __m128i t = _mm_min_epu32(low, high);
+        high = _mm_max_epu32(low, high);
+        low = t;
+    }
+    *lo = _mm_alignr_epi8(low, low, 4);
+    *hi = high;
+}
+
+/**
+ * Appends a sorted vector to out, skipping ids equal to the last one stored.
+ */
+static inline int store_unique(unsigned int *out, int n, const unsigned int *v, int count)
+{
+    for (int k = 0; k < count; k++)
+    {
+        if (n == 0 || out[n - 1] != v[k])
+            out[n++] = v[k];
+    }
+    return n;
+}
+
+/**
+ * Vector merge union. The next block always comes from the list
+ * whose head is smaller, so every emitted block is final.
+ */
+__attribute__((target("sse4.1")))
+int postings_union_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    if (na < 4 || nb < 4)
+        return postings_union_scalar(a, na, b, nb, out);
+
+    unsigned int buf[4];
+    __m128i lo, hi;
+    int i = 4, j = 4, n = 0;
+
+    merge_network(_mm_loadu_si128((const __m128i *)a), _mm_loadu_si128((const __m128i *)b), &lo, &hi);
+    _mm_storeu_si128((__m128i *)buf, lo);
+    n = store_unique(out, n, buf, 4);
+
+    while (i + 4 <= na && j + 4 <= nb)
+    {
+        __m128i next;
+        if (a[i] <= b[j])
+        {
+            next = _mm_loadu_si128((const __m128i *)(a + i));
+            i += 4;
+        }
+        else
+        {
+            next = _mm_loadu_si128((const __m128i *)(b + j));
+            j += 4;
+        }
+        merge_network(next, hi, &lo, &hi);
+        _mm_storeu_si128((__m128i *)buf, lo);
+        n = store_unique(out, n, buf, 4);
+    }
+
+    // Three-way scalar merge of the pending vector and both remainders
+    _mm_storeu_si128((__m128i *)buf, hi);
+    int k = 0;
+    while (k < 4 || i < na || j < nb)
+    {
+        unsigned int v = 0xFFFFFFFFu;
+        int src = -1;
+        if (k < 4)
+        {
+            v = buf[k];
+            src = 0;
+        }
+        if (i < na && (src < 0 || a[i] < v))
+        {
+            v = a[i];
+            src = 1;
+        }
+        if (j < nb && (src < 0 || b[j] < v))
+        {
+            v = b[j];
+            src = 2;
+        }
+        if (src == 0)
+            k++;
+        else if (src == 1)
+            i++;
+        else
+            j++;
+        n = store_unique(out, n, &v, 1);
+    }
+    return n;
+}
+
+#else
+
+/* Non-x86 builds only have the scalar kernels */
+int postings_intersect_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    return postings_intersect_scalar(a, na, b, nb, out);
+}
+
+int postings_intersect_avx2(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    return postings_intersect_scalar(a, na, b, nb, out);
+}
+
+int postings_union_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out)
+{
+    return postings_union_scalar(a, na, b, nb, out);
+}
+
+#endif
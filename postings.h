@@ -0,0 +1,59 @@
+/***********************************************************************
+ *  File name   : postings.h
+ *  Description : Header file for posting list kernels of the Inverted
+ *                Search Project.
+ *                Posting lists are sorted arrays of unique document ids.
+ *                postings_intersect() and postings_union() pick the
+ *                fastest kernel for the running CPU (AVX2, SSE4.1 or
+ *                scalar) and switch to galloping when one list is much
+ *                shorter than the other.
+ *
+ *                Functions:
+ *                - postings_simd_level()
+ *                - postings_intersect()
+ *                - postings_union()
+ *                - postings_intersect_scalar()
+ *                - postings_intersect_galloping()
+ *                - postings_intersect_sse41()
+ *                - postings_intersect_avx2()
+ *                - postings_union_scalar()
+ *                - postings_union_sse41()
+ *
+ ***********************************************************************/
+
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#define POSTINGS_SIMD_NONE 0
+#define POSTINGS_SIMD_SSE41 1
+#define POSTINGS_SIMD_AVX2 2
+
+#define POSTINGS_GALLOP_RATIO 32   // Size ratio above which galloping is used
+
+/**
+ * Returns the best SIMD level supported by the running CPU.
+ */
+int postings_simd_level(void);
+
+/**
+ * Writes the ids present in both a and b to out (room for the
+ * shorter list is enough). Returns the number of ids written.
+ */
+int postings_intersect(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+
+/**
+ * Writes the ids present in a or b to out (room for na + nb ids).
+ * Returns the number of ids written.
+ */
+int postings_union(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+
+/* Individual kernels. The SIMD ones must only be called when
+ * postings_simd_level() reports support for them. */
+int postings_intersect_scalar(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+int postings_intersect_galloping(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+int postings_intersect_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+int postings_intersect_avx2(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+int postings_union_scalar(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+int postings_union_sse41(const unsigned int *a, int na, const unsigned int *b, int nb, unsigned int *out);
+
+#endif
@@ -0,0 +1,718 @@
+/***********************************************************************
+ *  File name   : roaring.c
+ *  Description : Implementation file for the compressed document id
+ *                set of the Inverted Search Project.
+ *                AND/OR work container by container. Two ARRAY
+ *                containers are merged directly, every other pair is
+ *                combined as 64-bit words and converted back to the
+ *                smaller of ARRAY and BITMAP.
+ *
+ *                Functions:
+ *                - roaring_init()
+ *                - roaring_free()
+ *                - roaring_copy()
+ *                - roaring_add()
+ *                - roaring_contains()
+ *                - roaring_index()
+ *                - roaring_cardinality()
+ *                - roaring_max()
+ *                - roaring_and()
+ *                - roaring_or()
+ *                - roaring_to_array()
+ *                - roaring_optimize()
+ *                - roaring_iter_init()
+ *                - roaring_iterate()
+ *
+ ***********************************************************************/
+
+#include "roaring.h"
+#include "list.h"
+
+/* ----------- Container helpers ----------- */
+
+static void container_init(RoaringContainer *c)
+{
+    c->type = ROARING_ARRAY;
+    c->cardinality = 0;
+    c->length = 0;
+    c->capacity = 0;
+    c->values = NULL;
+    c->words = NULL;
+}
+
+static void container_release(RoaringContainer *c)
+{
+    free(c->values);
+    free(c->words);
+    container_init(c);
+}
+
+/**
+ * Returns the first position of values[0..n) holding a value >= x.
+ */
+static int lower_bound16(const unsigned short *values, int n, unsigned short x)
+{
+    int lo = 0, hi = n;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (values[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Sets bits start..end (inclusive) of a bitmap.
+ */
+static void set_bit_range(unsigned long long *words, int start, int end)
+{
+    int first = start >> 6, last = end >> 6;
+    unsigned long long firstMask = ~0ULL << (start & 63);
+    unsigned long long lastMask = ~0ULL >> (63 - (end & 63));
+    if (first == last)
+    {
+        words[first] |= firstMask & lastMask;
+        return;
+    }
+    words[first] |= firstMask;
+    for (int w = first + 1; w < last; w++)
+        words[w] = ~0ULL;
+    words[last] |= lastMask;
+}
+
+/**
+ * Writes the container into a zeroed-out bitmap of ROARING_BITMAP_WORDS.
+ */
+static void container_fill_words(const RoaringContainer *c, unsigned long long *words)
+{
+    memset(words, 0, ROARING_BITMAP_WORDS * sizeof(unsigned long long));
+    if (c->type == ROARING_BITMAP)
+        memcpy(words, c->words, ROARING_BITMAP_WORDS * sizeof(unsigned long long));
+    else if (c->type == ROARING_ARRAY)
+    {
+        for (int i = 0; i < c->length; i++)
+            words[c->values[i] >> 6] |= 1ULL << (c->values[i] & 63);
+    }
+    else
+    {
+        for (int i = 0; i < c->length; i++)
+            set_bit_range(words, c->values[2 * i], c->values[2 * i] + c->values[2 * i + 1]);
+    }
+}
+
+/**
+ * Builds an ARRAY or BITMAP container (whichever is smaller) from a bitmap.
+ */
+static int container_from_words(RoaringContainer *c, const unsigned long long *words)
+{
+    container_init(c);
+    int card = 0;
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++)
+        card += __builtin_popcountll(words[w]);
+    if (card == 0)
+        return SUCCESS;
+
+    if (card <= ROARING_ARRAY_MAX)
+    {
+        c->values = malloc(card * sizeof(unsigned short));
+        if (c->values == NULL)
+            return FAILURE;
+        int n = 0;
+        for (int w = 0; w < ROARING_BITMAP_WORDS; w++)
+        {
+            for (unsigned long long bits = words[w]; bits; bits &= bits - 1)
+                c->values[n++] = (unsigned short)(w * 64 + __builtin_ctzll(bits));
+        }
+        c->length = c->capacity = card;
+    }
+    else
+    {
+        c->words = malloc(ROARING_BITMAP_WORDS * sizeof(unsigned long long));
+        if (c->words == NULL)
+            return FAILURE;
+        memcpy(c->words, words, ROARING_BITMAP_WORDS * sizeof(unsigned long long));
+        c->type = ROARING_BITMAP;
+    }
+    c->cardinality = card;
+    return SUCCESS;
+}
+
+/**
+ * Rewrites a RUN container as ARRAY or BITMAP so that it can take
+ * values which do not extend its last run.
+ */
+static int container_unrun(RoaringContainer *c)
+{
+    unsigned long long words[ROARING_BITMAP_WORDS];
+    container_fill_words(c, words);
+
+    RoaringContainer converted;
+    if (container_from_words(&converted, words) == FAILURE)
+        return FAILURE;
+    container_release(c);
+    *c = converted;
+    return SUCCESS;
+}
+
+static int container_add(RoaringContainer *c, unsigned short v)
+{
+    if (c->type == ROARING_RUN)
+    {
+        int last = c->length - 1;
+        unsigned short start = c->values[2 * last], len = c->values[2 * last + 1];
+        if (v >= start && v <= start + len)
+            return SUCCESS;
+        // Appending right after the last run keeps the container a RUN
+        if (v == start + len + 1)
+        {
+            c->values[2 * last + 1]++;
+            c->cardinality++;
+            return SUCCESS;
+        }
+        if (container_unrun(c) == FAILURE)
+            return FAILURE;
+    }
+
+    if (c->type == ROARING_ARRAY)
+    {
+        int pos = lower_bound16(c->values, c->length, v);
+        if (pos < c->length && c->values[pos] == v)
+            return SUCCESS;
+
+        if (c->length == ROARING_ARRAY_MAX)
+        {
+            // Array is full → switch to a bitmap
+            unsigned long long *words = calloc(ROARING_BITMAP_WORDS, sizeof(unsigned long long));
+            if (words == NULL)
+                return FAILURE;
+            for (int i = 0; i < c->length; i++)
+                words[c->values[i] >> 6] |= 1ULL << (c->values[i] & 63);
+            free(c->values);
+            c->values = NULL;
+            c->length = c->capacity = 0;
+            c->words = words;
+            c->type = ROARING_BITMAP;
+        }
+        else
+        {
+            if (c->length == c->capacity)
+            {
+                int capacity = c->capacity ? c->capacity * 2 : 4;
+                if (capacity > ROARING_ARRAY_MAX)
+                    capacity = ROARING_ARRAY_MAX;
+                unsigned short *values = realloc(c->values, capacity * sizeof(unsigned short));
+                if (values == NULL)
+                    return FAILURE;
+                c->values = values;
+                c->capacity = capacity;
+            }
+            memmove(c->values + pos + 1, c->values + pos, (c->length - pos) * sizeof(unsigned short));
+            c->values[pos] = v;
+            c->length++;
+            c->cardinality++;
+            return SUCCESS;
+        }
+    }
+
+    unsigned long long bit = 1ULL << (v & 63);
+    if ((c->words[v >> 6] & bit) == 0)
+    {
+        c->words[v >> 6] |= bit;
+        c->cardinality++;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Returns the position of v inside the container, or -1 if absent.
+ */
+static int container_index(const RoaringContainer *c, unsigned short v)
+{
+    if (c->type == ROARING_ARRAY)
+    {
+        int pos = lower_bound16(c->values, c->length, v);
+        return (pos < c->length && c->values[pos] == v) ? pos : -1;
+    }
+    if (c->type == ROARING_BITMAP)
+    {
+        int w = v >> 6;
+        if ((c->words[w] & (1ULL << (v & 63))) == 0)
+            return -1;
+        int rank = 0;
+        for (int i = 0; i < w; i++)
+            rank += __builtin_popcountll(c->words[i]);
+        return rank + __builtin_popcountll(c->words[w] & ((1ULL << (v & 63)) - 1));
+    }
+
+    int rank = 0;
+    for (int i = 0; i < c->length; i++)
+    {
+        int start = c->values[2 * i], len = c->values[2 * i + 1];
+        if (v < start)
+            return -1;
+        if (v <= start + len)
+            return rank + v - start;
+        rank += len + 1;
+    }
+    return -1;
+}
+
+static int container_max(const RoaringContainer *c)
+{
+    if (c->type == ROARING_ARRAY)
+        return c->values[c->length - 1];
+    if (c->type == ROARING_RUN)
+        return c->values[2 * c->length - 2] + c->values[2 * c->length - 1];
+    for (int w = ROARING_BITMAP_WORDS - 1; w >= 0; w--)
+    {
+        if (c->words[w])
+            return w * 64 + 63 - __builtin_clzll(c->words[w]);
+    }
+    return -1;
+}
+
+static int container_and(const RoaringContainer *a, const RoaringContainer *b, RoaringContainer *out)
+{
+    container_init(out);
+    if (a->type == ROARING_ARRAY && b->type == ROARING_ARRAY)
+    {
+        int max = a->length < b->length ? a->length : b->length;
+        if (max == 0)
+            return SUCCESS;
+        out->values = malloc(max * sizeof(unsigned short));
+        if (out->values == NULL)
+            return FAILURE;
+        int i = 0, j = 0, n = 0;
+        while (i < a->length && j < b->length)
+        {
+            if (a->values[i] < b->values[j])
+                i++;
+            else if (a->values[i] > b->values[j])
+                j++;
+            else
+            {
+                out->values[n++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+        out->length = out->cardinality = n;
+        out->capacity = max;
+        return SUCCESS;
+    }
+
+    unsigned long long wa[ROARING_BITMAP_WORDS], wb[ROARING_BITMAP_WORDS];
+    container_fill_words(a, wa);
+    container_fill_words(b, wb);
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++)
+        wa[w] &= wb[w];
+    return container_from_words(out, wa);
+}
+
+static int container_or(const RoaringContainer *a, const RoaringContainer *b, RoaringContainer *out)
+{
+    container_init(out);
+    if (a->type == ROARING_ARRAY && b->type == ROARING_ARRAY && a->length + b->length <= ROARING_ARRAY_MAX)
+    {
+        int max = a->length + b->length;
+        if (max == 0)
+            return SUCCESS;
+        out->values = malloc(max * sizeof(unsigned short));
+        if (out->values == NULL)
+            return FAILURE;
+        int i = 0, j = 0, n = 0;
+        while (i < a->length && j < b->length)
+        {
+            if (a->values[i] < b->values[j])
+                out->values[n++] = a->values[i++];
+            else if (a->values[i] > b->values[j])
+                out->values[n++] = b->values[j++];
+            else
+            {
+                out->values[n++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+        while (i < a->length)
+            out->values[n++] = a->values[i++];
+        while (j < b->length)
+            out->values[n++] = b->values[j++];
+        out->length = out->cardinality = n;
+        out->capacity = max;
+        return SUCCESS;
+    }
+
+    unsigned long long wa[ROARING_BITMAP_WORDS], wb[ROARING_BITMAP_WORDS];
+    container_fill_words(a, wa);
+    container_fill_words(b, wb);
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++)
+        wa[w] |= wb[w];
+    return container_from_words(out, wa);
+}
+
+/**
+ * Rebuilds a container as RUN when (start, length) pairs are the
+ * smallest of the three layouts.
+ */
+static int container_optimize(RoaringContainer *c)
+{
+    if (c->cardinality == 0)
+        return SUCCESS;
+
+    unsigned long long words[ROARING_BITMAP_WORDS];
+    container_fill_words(c, words);
+
+    // A run starts at every set bit whose lower neighbour is clear
+    int runs = 0;
+    unsigned long long carry = 0;
+    for (int w = 0; w < ROARING_BITMAP_WORDS; w++)
+    {
+        runs += __builtin_popcountll(words[w] & ~((words[w] << 1) | carry));
+        carry = words[w] >> 63;
+    }
+
+    long runBytes = 4L * runs;
+    long arrayBytes = 2L * c->cardinality;
+    long bitmapBytes = 8L * ROARING_BITMAP_WORDS;
+    if (runBytes >= arrayBytes || runBytes >= bitmapBytes)
+    {
+        if (c->type == ROARING_RUN)
+            return container_unrun(c);
+        return SUCCESS;
+    }
+    if (c->type == ROARING_RUN)
+        return SUCCESS;
+
+    unsigned short *values = malloc(2 * runs * sizeof(unsigned short));
+    if (values == NULL)
+        return FAILURE;
+    int n = 0, card = c->cardinality;
+    for (int v = 0; v < 65536; )
+    {
+        unsigned long long bits = words[v >> 6] >> (v & 63);
+        if (bits == 0)
+        {
+            v = ((v >> 6) + 1) << 6;
+            continue;
+        }
+        v += __builtin_ctzll(bits);
+        int start = v;
+        while (v < 65536 && (words[v >> 6] & (1ULL << (v & 63))))
+            v++;
+        values[2 * n] = (unsigned short)start;
+        values[2 * n + 1] = (unsigned short)(v - 1 - start);
+        n++;
+    }
+
+    container_release(c);
+    c->type = ROARING_RUN;
+    c->values = values;
+    c->length = c->capacity = runs;
+    c->cardinality = card;
+    return SUCCESS;
+}
+
+/* ----------- Set operations ----------- */
+
+/**
+ * Returns the container index holding key, or -(insert position) - 1.
+ */
+static int find_key(const Roaring *set, unsigned short key)
+{
+    int lo = 0, hi = set->count - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (set->keys[mid] < key)
+            lo = mid + 1;
+        else if (set->keys[mid] > key)
+            hi = mid - 1;
+        else
+            return mid;
+    }
+    return -lo - 1;
+}
+
+/**
+ * Opens an empty container for key at position pos.
+ */
+static RoaringContainer *insert_container(Roaring *set, int pos, unsigned short key)
+{
+    if (set->count == set->capacity)
+    {
+        int capacity = set->capacity ? set->capacity * 2 : 1;
+        unsigned short *keys = realloc(set->keys, capacity * sizeof(unsigned short));
+        if (keys == NULL)
+            return NULL;
+        set->keys = keys;
+        RoaringContainer *containers = realloc(set->containers, capacity * sizeof(RoaringContainer));
+        if (containers == NULL)
+            return NULL;
+        set->containers = containers;
+        set->capacity = capacity;
+    }
+    memmove(set->keys + pos + 1, set->keys + pos, (set->count - pos) * sizeof(unsigned short));
+    memmove(set->containers + pos + 1, set->containers + pos, (set->count - pos) * sizeof(RoaringContainer));
+    set->keys[pos] = key;
+    container_init(&set->containers[pos]);
+    set->count++;
+    return &set->containers[pos];
+}
+
+/**
+ * Moves a non-empty container to the end of out, releases it otherwise.
+ */
+static int append_container(Roaring *out, unsigned short key, RoaringContainer *c)
+{
+    if (c->cardinality == 0)
+    {
+        container_release(c);
+        return SUCCESS;
+    }
+    RoaringContainer *slot = insert_container(out, out->count, key);
+    if (slot == NULL)
+    {
+        container_release(c);
+        return FAILURE;
+    }
+    *slot = *c;
+    return SUCCESS;
+}
+
+void roaring_init(Roaring *set)
+{
+    set->keys = NULL;
+    set->containers = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+void roaring_free(Roaring *set)
+{
+    for (int i = 0; i < set->count; i++)
+        container_release(&set->containers[i]);
+    free(set->keys);
+    free(set->containers);
+    roaring_init(set);
+}
+
+int roaring_copy(Roaring *dst, const Roaring *src)
+{
+    roaring_init(dst);
+    for (int i = 0; i < src->count; i++)
+    {
+        const RoaringContainer *from = &src->containers[i];
+        RoaringContainer *to = insert_container(dst, dst->count, src->keys[i]);
+        if (to == NULL)
+        {
+            roaring_free(dst);
+            return FAILURE;
+        }
+        *to = *from;
+        to->values = NULL;
+        to->words = NULL;
+        to->capacity = from->length;
+
+        // RUN containers hold (start, length) pairs
+        size_t bytes = from->type == ROARING_BITMAP ? ROARING_BITMAP_WORDS * sizeof(unsigned long long)
+                     : (size_t)from->length * (from->type == ROARING_RUN ? 2 : 1) * sizeof(unsigned short);
+        if (bytes == 0)
+            continue;
+        void *copy = malloc(bytes);
+        if (copy == NULL)
+        {
+            container_init(to);
+            roaring_free(dst);
+            return FAILURE;
+        }
+        memcpy(copy, from->type == ROARING_BITMAP ? (void *)from->words : (void *)from->values, bytes);
+        if (from->type == ROARING_BITMAP)
+            to->words = copy;
+        else
+            to->values = copy;
+    }
+    return SUCCESS;
+}
+
+int roaring_add(Roaring *set, unsigned int id)
+{
+    unsigned short key = (unsigned short)(id >> 16);
+    int pos = find_key(set, key);
+    RoaringContainer *c;
+    if (pos >= 0)
+        c = &set->containers[pos];
+    else if ((c = insert_container(set, -pos - 1, key)) == NULL)
+        return FAILURE;
+    return container_add(c, (unsigned short)(id & 0xFFFF));
+}
+
+int roaring_contains(const Roaring *set, unsigned int id)
+{
+    int pos = find_key(set, (unsigned short)(id >> 16));
+    return pos >= 0 && container_index(&set->containers[pos], (unsigned short)(id & 0xFFFF)) >= 0;
+}
+
+int roaring_index(const Roaring *set, unsigned int id)
+{
+    int pos = find_key(set, (unsigned short)(id >> 16));
+    if (pos < 0)
+        return FAILURE;
+    int index = container_index(&set->containers[pos], (unsigned short)(id & 0xFFFF));
+    if (index < 0)
+        return FAILURE;
+    for (int i = 0; i < pos; i++)
+        index += set->containers[i].cardinality;
+    return index;
+}
+
+int roaring_cardinality(const Roaring *set)
+{
+    int card = 0;
+    for (int i = 0; i < set->count; i++)
+        card += set->containers[i].cardinality;
+    return card;
+}
+
+int roaring_max(const Roaring *set)
+{
+    if (set->count == 0)
+        return FAILURE;
+    return ((int)set->keys[set->count - 1] << 16) | container_max(&set->containers[set->count - 1]);
+}
+
+int roaring_and(const Roaring *a, const Roaring *b, Roaring *out)
+{
+    roaring_init(out);
+    int i = 0, j = 0;
+    while (i < a->count && j < b->count)
+    {
+        if (a->keys[i] < b->keys[j])
+            i++;
+        else if (a->keys[i] > b->keys[j])
+            j++;
+        else
+        {
+            RoaringContainer c;
+            if (container_and(&a->containers[i], &b->containers[j], &c) == FAILURE ||
+                append_container(out, a->keys[i], &c) == FAILURE)
+            {
+                roaring_free(out);
+                return FAILURE;
+            }
+            i++;
+            j++;
+        }
+    }
+    return SUCCESS;
+}
+
+int roaring_or(const Roaring *a, const Roaring *b, Roaring *out)
+{
+    static const RoaringContainer empty = {ROARING_ARRAY, 0, 0, 0, NULL, NULL};
+    roaring_init(out);
+    int i = 0, j = 0;
+    while (i < a->count || j < b->count)
+    {
+        const RoaringContainer *ca = &empty, *cb = &empty;
+        unsigned short key;
+        if (j == b->count || (i < a->count && a->keys[i] < b->keys[j]))
+        {
+            key = a->keys[i];
+            ca = &a->containers[i++];
+        }
+        else if (i == a->count || b->keys[j] < a->keys[i])
+        {
+            key = b->keys[j];
+            cb = &b->containers[j++];
+        }
+        else
+        {
+            key = a->keys[i];
+            ca = &a->containers[i++];
+            cb = &b->containers[j++];
+        }
+
+        RoaringContainer c;
+        if (container_or(ca, cb, &c) == FAILURE || append_container(out, key, &c) == FAILURE)
+        {
+            roaring_free(out);
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+int roaring_to_array(const Roaring *set, unsigned int *out)
+{
+    RoaringIter iter;
+    unsigned int id;
+    int n = 0;
+    roaring_iter_init(&iter, set);
+    while (roaring_iterate(&iter, &id))
+        out[n++] = id;
+    return n;
+}
+
+void roaring_optimize(Roaring *set)
+{
+    for (int i = 0; i < set->count; i++)
+        container_optimize(&set->containers[i]);
+}
+
+void roaring_iter_init(RoaringIter *iter, const Roaring *set)
+{
+    iter->set = set;
+    iter->container = 0;
+    iter->pos = 0;
+    iter->offset = 0;
+}
+
+int roaring_iterate(RoaringIter *iter, unsigned int *id)
+{
+    while (iter->container < iter->set->count)
+    {
+        const RoaringContainer *c = &iter->set->containers[iter->container];
+        unsigned int high = (unsigned int)iter->set->keys[iter->container] << 16;
+
+        if (c->type == ROARING_ARRAY && iter->pos < c->length)
+        {
+            *id = high | c->values[iter->pos++];
+            return 1;
+        }
+        if (c->type == ROARING_BITMAP)
+        {
+            while (iter->pos < 65536)
+            {
+                unsigned long long bits = c->words[iter->pos >> 6] >> (iter->pos & 63);
+                if (bits)
+                {
+                    iter->pos += __builtin_ctzll(bits);
+                    *id = high | (unsigned int)iter->pos++;
+                    return 1;
+                }
+                iter->pos = ((iter->pos >> 6) + 1) << 6;
+            }
+        }
+        if (c->type == ROARING_RUN && iter->pos < c->length)
+        {
+            *id = high | (unsigned int)(c->values[2 * iter->pos] + iter->offset);
+            if (iter->offset == c->values[2 * iter->pos + 1])
+            {
+                iter->pos++;
+                iter->offset = 0;
+            }
+            else
+                iter->offset++;
+            return 1;
+        }
+
+        iter->container++;
+        iter->pos = 0;
+        iter->offset = 0;
+    }
+    return 0;
+}
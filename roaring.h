@@ -0,0 +1,147 @@
+/***********************************************************************
+ *  File name   : roaring.h
+ *  Description : Header file for the compressed document id set used
+ *                by dense posting lists in the Inverted Search Project.
+ *                Ids are split on their high 16 bits into containers,
+ *                each container holding the low 16 bits as either:
+ *                - ARRAY  : sorted values (up to ROARING_ARRAY_MAX)
+ *                - BITMAP : 65536 bits in 64-bit words
+ *                - RUN    : (start, length) pairs of consecutive values
+ *
+ *                Functions:
+ *                - roaring_init()
+ *                - roaring_free()
+ *                - roaring_copy()
+ *                - roaring_add()
+ *                - roaring_contains()
+ *                - roaring_index()
+ *                - roaring_cardinality()
+ *                - roaring_max()
+ *                - roaring_and()
+ *                - roaring_or()
+ *                - roaring_to_array()
+ *                - roaring_optimize()
+ *                - roaring_iter_init()
+ *                - roaring_iterate()
+ *
+ ***********************************************************************/
+
+#ifndef ROARING_H
+#define ROARING_H
+
+#define ROARING_ARRAY 0
+#define ROARING_BITMAP 1
+#define ROARING_RUN 2
+
+#define ROARING_ARRAY_MAX 4096       // Largest ARRAY container, BITMAP above
+#define ROARING_BITMAP_WORDS 1024    // 64-bit words in a BITMAP container
+
+/* RoaringContainer:
+ * Low 16 bits of every id sharing the same high 16 bits.
+ */
+typedef struct RoaringContainer
+{
+    int type;                    // ROARING_ARRAY, ROARING_BITMAP or ROARING_RUN
+    int cardinality;             // Number of values in the container
+    int length;                  // Used values (ARRAY) or pairs (RUN)
+    int capacity;                // Allocated values (ARRAY) or pairs (RUN)
+    unsigned short *values;      // ARRAY: sorted values, RUN: start/length-1 pairs
+    unsigned long long *words;   // BITMAP: ROARING_BITMAP_WORDS words
+} RoaringContainer;
+
+/* Roaring:
+ * Set of 32-bit ids, containers sorted by key (high 16 bits).
+ */
+typedef struct Roaring
+{
+    unsigned short *keys;            // High 16 bits of each container
+    RoaringContainer *containers;    // Containers, same order as keys
+    int count;                       // Number of containers
+    int capacity;                    // Allocated containers
+} Roaring;
+
+/* RoaringIter:
+ * Position of an ascending walk over a Roaring set.
+ */
+typedef struct RoaringIter
+{
+    const Roaring *set;
+    int container;               // Current container
+    int pos;                     // Value index (ARRAY), bit (BITMAP) or run (RUN)
+    int offset;                  // Offset inside the current run
+} RoaringIter;
+
+/**
+ * Initializes an empty set.
+ */
+void roaring_init(Roaring *set);
+
+/**
+ * Releases every container of the set.
+ */
+void roaring_free(Roaring *set);
+
+/**
+ * Stores a copy of src in dst (initialized by the call).
+ * Returns SUCCESS or FAILURE.
+ */
+int roaring_copy(Roaring *dst, const Roaring *src);
+
+/**
+ * Adds an id to the set. Returns SUCCESS or FAILURE.
+ */
+int roaring_add(Roaring *set, unsigned int id);
+
+/**
+ * Returns 1 if the id is in the set, 0 otherwise.
+ */
+int roaring_contains(const Roaring *set, unsigned int id);
+
+/**
+ * Returns the position of id in ascending order, or FAILURE if absent.
+ */
+int roaring_index(const Roaring *set, unsigned int id);
+
+/**
+ * Returns the number of ids in the set.
+ */
+int roaring_cardinality(const Roaring *set);
+
+/**
+ * Returns the largest id of the set, or FAILURE if it is empty.
+ */
+int roaring_max(const Roaring *set);
+
+/**
+ * Stores a AND b in out (initialized by the call).
+ * Returns SUCCESS or FAILURE.
+ */
+int roaring_and(const Roaring *a, const Roaring *b, Roaring *out);
+
+/**
+ * Stores a OR b in out (initialized by the call).
+ * Returns SUCCESS or FAILURE.
+ */
+int roaring_or(const Roaring *a, const Roaring *b, Roaring *out);
+
+/**
+ * Writes the ids in ascending order, returns how many were written.
+ */
+int roaring_to_array(const Roaring *set, unsigned int *out);
+
+/**
+ * Converts every container to its smallest form (ARRAY, BITMAP or RUN).
+ */
+void roaring_optimize(Roaring *set);
+
+/**
+ * Positions an iterator before the first id of the set.
+ */
+void roaring_iter_init(RoaringIter *iter, const Roaring *set);
+
+/**
+ * Stores the next id in *id. Returns 1, or 0 once the set is exhausted.
+ */
+int roaring_iterate(RoaringIter *iter, unsigned int *id);
+
+#endif
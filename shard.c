@@ -0,0 +1,365 @@
+/***********************************************************************
+ *  File name   : shard.c
+ *  Description : Implementation file for the sharded mode of the
+ *                Inverted Search Project.
+ *                Workers are forked processes connected to the
+ *                coordinator by a UNIX socket pair. Messages are fixed
+ *                size structs: a ShardRequest per query, answered by a
+ *                hit count followed by that many ShardHits.
+ *
+ *                Functions:
+ *                - shardCluster_start()
+ *                - shardCluster_search()
+ *                - shardCluster_stop()
+ *
+ ***********************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "shard.h"
+#include "database.h"
+
+#define SHARD_QUERY_ALL 1
+#define SHARD_QUERY_ANY 2
+#define SHARD_QUIT 3
+
+/* ShardRequest:
+ * One query sent to every worker.
+ */
+typedef struct ShardRequest
+{
+    int op;
+    int count;
+    char words[MAX_QUERY_WORDS][MAX_WORD_LENGTH];
+} ShardRequest;
+
+/* ShardStatus:
+ * Sent once by a worker when its index is built.
+ */
+typedef struct ShardStatus
+{
+    int files;
+    int words;
+} ShardStatus;
+
+/* ShardHit:
+ * A matching file and its total count of the query words.
+ */
+typedef struct ShardHit
+{
+    char filename[MAX_FILENAME_LENGTH];
+    int score;
+} ShardHit;
+
+/**
+ * Sends len bytes, retrying on short writes. A closed peer is reported
+ * as FAILURE instead of raising SIGPIPE.
+ */
+static int send_all(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    while (len > 0)
+    {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FAILURE;
+        p += n;
+        len -= n;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Receives exactly len bytes. Returns FAILURE on error or end of stream.
+ */
+static int recv_all(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+    while (len > 0)
+    {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FAILURE;
+        p += n;
+        len -= n;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Answers one query against the worker's index: the hit count (FAILURE
+ * if the worker ran out of memory) followed by the hits.
+ */
+static int shard_answer(int fd, HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, ShardRequest *request)
+{
+    unsigned int *result = malloc((docs->count + 1) * sizeof(unsigned int));
+    int *scores = calloc(docs->count + 1, sizeof(int));
+    ShardHit *hits = NULL;
+    int count = FAILURE;
+
+    // A malformed request matches nothing
+    if (request->count == 0)
+        count = 0;
+    else if (result && scores)
+        count = match_words(hashTable, docs, request->words, request->count, request->op == SHARD_QUERY_ALL, result);
+    if (count > 0 && (hits = malloc(count * sizeof(ShardHit))) == NULL)
+        count = FAILURE;
+    if (count > 0)
+    {
+        for (int i = 0; i < request->count; i++)
+        {
+            MainNode *node = termTable_find(&hashTable[(int)get_word_index(request->words[i])].terms, request->words[i]);
+            if (node == NULL)
+                continue;
+            PostingCursor cursor;
+            int docId, wordCount;
+            postingCursor_init(&cursor, node);
+            while (postingCursor_next(&cursor, &docId, &wordCount))
+                scores[docId] += wordCount;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            strcpy(hits[i].filename, docs->names[result[i]]);
+            hits[i].score = scores[result[i]];
+        }
+    }
+
+    int status = send_all(fd, &count, sizeof(int));
+    if (status == SUCCESS && count > 0)
+        status = send_all(fd, hits, count * sizeof(ShardHit));
+    free(result);
+    free(scores);
+    free(hits);
+    return status;
+}
+
+/**
+ * Body of a worker process: indexes every file whose position in
+ * filelist is shard modulo shardCount, then serves queries until told
+ * to quit or the coordinator goes away.
+ */
+static void shard_serve(int fd, FileList *filelist, int shard, int shardCount)
+{
+    FileList *mine = NULL;
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    ShardStatus status = {0, 0};
+
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    for (int i = 0; filelist; filelist = filelist->link, i++)
+    {
+        if (i % shardCount == shard && fileList_insert_last(&mine, filelist->filename) == FAILURE)
+            return;
+    }
+    if (mine && create_database(mine, hashTable, &docs, NULL) == FAILURE)
+        return;
+    fflush(stdout);
+
+    status.files = docs.count;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        status.words += hashTable[i].terms.size;
+    if (send_all(fd, &status, sizeof(status)) == FAILURE)
+        return;
+
+    ShardRequest request;
+    while (recv_all(fd, &request, sizeof(request)) == SUCCESS && request.op != SHARD_QUIT)
+    {
+        if (request.count < 1 || request.count > MAX_QUERY_WORDS)
+            request.count = 0;
+        for (int i = 0; i < request.count; i++)
+            request.words[i][MAX_WORD_LENGTH - 1] = '\0';
+        if (shard_answer(fd, hashTable, &docs, &request) == FAILURE)
+            return;
+    }
+}
+
+/**
+ * Forks the workers and waits for every one to report its index.
+ */
+int shardCluster_start(ShardCluster *cluster, FileList *filelist, int shardCount)
+{
+    if (shardCount < 1 || shardCount > MAX_SHARDS)
+    {
+        fprintf(stderr, "\nERROR: Number of shards must be between 1 and %d\n", MAX_SHARDS);
+        return FAILURE;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Buffered output would otherwise be printed again by every worker
+    fflush(stdout);
+    fflush(stderr);
+    cluster->count = 0;
+    for (int i = 0; i < shardCount; i++)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        {
+            fprintf(stderr, "\nERROR: Could not create socket for shard %d\n", i);
+            shardCluster_stop(cluster);
+            return FAILURE;
+        }
+        pid_t pid = fork();
+        if (pid == -1)
+        {
+            fprintf(stderr, "\nERROR: Could not start shard %d\n", i);
+            close(sv[0]);
+            close(sv[1]);
+            shardCluster_stop(cluster);
+            return FAILURE;
+        }
+        if (pid == 0)
+        {
+            close(sv[0]);
+            for (int j = 0; j < cluster->count; j++)
+                close(cluster->fds[j]);
+            // Indexing messages would interleave with the menu; errors still reach stderr
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull != -1)
+            {
+                dup2(devnull, STDOUT_FILENO);
+                close(devnull);
+            }
+            shard_serve(sv[1], filelist, i, shardCount);
+            fflush(stdout);
+            _exit(0);
+        }
+        close(sv[1]);
+        cluster->pids[i] = pid;
+        cluster->fds[i] = sv[0];
+        cluster->count++;
+    }
+
+    // The workers index their files concurrently
+    ShardStatus total = {0, 0};
+    for (int i = 0; i < cluster->count; i++)
+    {
+        ShardStatus status;
+        if (recv_all(cluster->fds[i], &status, sizeof(status)) == FAILURE)
+        {
+            fprintf(stderr, "\nERROR: Shard %d failed to build its index\n", i);
+            shardCluster_stop(cluster);
+            return FAILURE;
+        }
+        total.files += status.files;
+        total.words += status.words;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fprintf(stderr, "\nINFO: %d shards indexed %d files (%d shard terms) in %.3f s\n",
+            cluster->count, total.files, total.words,
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    return SUCCESS;
+}
+
+/* Compare function ranking hits by score, then by file name */
+static int compare_hit(const void *a, const void *b)
+{
+    const ShardHit *x = a, *y = b;
+    if (x->score != y->score)
+        return x->score < y->score ? 1 : -1;
+    return strcmp(x->filename, y->filename);
+}
+
+/**
+ * Scatters the query to every shard, then gathers and ranks the hits.
+ * Every answer is read even after a failure so that the sockets stay
+ * in step with the protocol.
+ */
+int shardCluster_search(ShardCluster *cluster, char words[][MAX_WORD_LENGTH], int count, int matchAll)
+{
+    if (cluster->count == 0)
+    {
+        fprintf(stderr, "\nINFO: Shards are not started\n");
+        return FAILURE;
+    }
+
+    ShardRequest request;
+    memset(&request, 0, sizeof(request));
+    request.op = matchAll ? SHARD_QUERY_ALL : SHARD_QUERY_ANY;
+    request.count = count < MAX_QUERY_WORDS ? count : MAX_QUERY_WORDS;
+    for (int i = 0; i < request.count; i++)
+        strcpy(request.words[i], words[i]);
+
+    int sent[MAX_SHARDS];
+    for (int i = 0; i < cluster->count; i++)
+        sent[i] = send_all(cluster->fds[i], &request, sizeof(request));
+
+    ShardHit *hits = NULL;
+    int hitCount = 0, status = SUCCESS;
+    for (int i = 0; i < cluster->count; i++)
+    {
+        int n;
+        if (sent[i] == FAILURE || recv_all(cluster->fds[i], &n, sizeof(int)) == FAILURE || n == FAILURE)
+        {
+            fprintf(stderr, "\nERROR: Shard %d did not answer\n", i);
+            status = FAILURE;
+            continue;
+        }
+        if (n == 0)
+            continue;
+        ShardHit *more = realloc(hits, (hitCount + n) * sizeof(ShardHit));
+        if (more == NULL)
+        {
+            // Drain the answer, the results are incomplete anyway
+            ShardHit skip;
+            for (int k = 0; k < n; k++)
+                recv_all(cluster->fds[i], &skip, sizeof(skip));
+            fprintf(stderr, "\nERROR: Could not allocate memory for search\n");
+            status = FAILURE;
+            continue;
+        }
+        hits = more;
+        if (recv_all(cluster->fds[i], hits + hitCount, n * sizeof(ShardHit)) == FAILURE)
+        {
+            fprintf(stderr, "\nERROR: Shard %d did not answer\n", i);
+            status = FAILURE;
+            continue;
+        }
+        hitCount += n;
+    }
+
+    if (status == SUCCESS)
+    {
+        qsort(hits, hitCount, sizeof(ShardHit), compare_hit);
+        if (hitCount == 0)
+            printf("\nNo file in the DATABASE contains %s of the given words\n", matchAll ? "all" : "any");
+        else
+        {
+            printf("\n%s of the given words present in (%d) file\n", matchAll ? "All" : "Some", hitCount);
+            for (int i = 0; i < hitCount; i++)
+                printf("In File : '%s' (%d) Time\n", hits[i].filename, hits[i].score);
+        }
+    }
+    free(hits);
+    return status;
+}
+
+/**
+ * Asks every worker to quit and reaps it.
+ */
+void shardCluster_stop(ShardCluster *cluster)
+{
+    ShardRequest request;
+    memset(&request, 0, sizeof(request));
+    request.op = SHARD_QUIT;
+    for (int i = 0; i < cluster->count; i++)
+    {
+        send_all(cluster->fds[i], &request, sizeof(request));
+        close(cluster->fds[i]);
+    }
+    for (int i = 0; i < cluster->count; i++)
+        waitpid(cluster->pids[i], NULL, 0);
+    cluster->count = 0;
+}
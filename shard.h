@@ -0,0 +1,56 @@
+/***********************************************************************
+ *  File name   : shard.h
+ *  Description : Header file for the sharded mode of the Inverted
+ *                Search Project.
+ *                The input files are split round-robin over several
+ *                worker processes. Each worker builds and owns the index
+ *                of its files; the coordinator sends every query to all
+ *                workers over a local socket and merges their answers.
+ *                Since every file lives on exactly one shard, the merged
+ *                AND/OR results equal those of a single index.
+ *
+ *                Functions:
+ *                - shardCluster_start()
+ *                - shardCluster_search()
+ *                - shardCluster_stop()
+ *
+ ***********************************************************************/
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <sys/types.h>
+
+#include "list.h"
+
+#define MAX_SHARDS 64                   // Largest number of worker processes
+
+/* ShardCluster:
+ * The worker processes and the coordinator end of their sockets.
+ */
+typedef struct ShardCluster
+{
+    int count;                          // Number of running shards, 0 if stopped
+    pid_t pids[MAX_SHARDS];
+    int fds[MAX_SHARDS];
+} ShardCluster;
+
+/**
+ * Starts shardCount workers, each indexing its share of filelist, and
+ * waits until all of them are ready. Returns SUCCESS or FAILURE.
+ */
+int shardCluster_start(ShardCluster *cluster, FileList *filelist, int shardCount);
+
+/**
+ * Prints the files containing all (matchAll = 1) or any of the words,
+ * ranked by the total number of occurrences of the words.
+ * Returns SUCCESS or FAILURE.
+ */
+int shardCluster_search(ShardCluster *cluster, char words[][MAX_WORD_LENGTH], int count, int matchAll);
+
+/**
+ * Stops the workers and waits for them to exit.
+ */
+void shardCluster_stop(ShardCluster *cluster);
+
+#endif
@@ -0,0 +1,127 @@
+/***********************************************************************
+ *  File name   : snapshot.c
+ *  Description : Implementation file for versioned index snapshots of
+ *                the Inverted Search Project.
+ *
+ *                Functions:
+ *                - snapshotStore_init()
+ *                - snapshot_create()
+ *                - snapshot_clone()
+ *                - snapshot_acquire()
+ *                - snapshot_release()
+ *                - snapshot_publish()
+ *
+ ***********************************************************************/
+
+#include "snapshot.h"
+
+/**
+ * Allocates an empty snapshot with one reference held by the caller.
+ */
+IndexSnapshot *snapshot_create(void)
+{
+    IndexSnapshot *snapshot = malloc(sizeof(IndexSnapshot));
+    if (snapshot == NULL)
+    {
+        fprintf(stderr, "\nERROR: Memory allocation failed for index snapshot\n");
+        return NULL;
+    }
+    initialize_hashTable(snapshot->hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&snapshot->docs);
+    termSketch_init(&snapshot->sketch, SKETCH_CAPACITY);
+    snapshot->version = 0;
+    atomic_init(&snapshot->refCount, 1);
+    return snapshot;
+}
+
+/**
+ * Publishes an empty snapshot as version 0.
+ */
+int snapshotStore_init(SnapshotStore *store)
+{
+    if (pthread_mutex_init(&store->lock, NULL) != 0)
+        return FAILURE;
+    store->current = snapshot_create();
+    store->nextVersion = 1;
+    return store->current ? SUCCESS : FAILURE;
+}
+
+/**
+ * Pins the current snapshot. The reference is taken under the lock so
+ * that a concurrent publish cannot free it in between.
+ */
+IndexSnapshot *snapshot_acquire(SnapshotStore *store)
+{
+    pthread_mutex_lock(&store->lock);
+    IndexSnapshot *snapshot = store->current;
+    atomic_fetch_add(&snapshot->refCount, 1);
+    pthread_mutex_unlock(&store->lock);
+    return snapshot;
+}
+
+/**
+ * Drops one reference, freeing the snapshot with the last one.
+ */
+void snapshot_release(IndexSnapshot *snapshot)
+{
+    if (atomic_fetch_sub(&snapshot->refCount, 1) != 1)
+        return;
+    free_hashTable(snapshot->hashTable);
+    free_docTable(&snapshot->docs);
+    termSketch_free(&snapshot->sketch);
+    free(snapshot);
+}
+
+/**
+ * Deep copies the current snapshot so that a writer can modify the copy
+ * while readers keep using the original.
+ */
+IndexSnapshot *snapshot_clone(SnapshotStore *store)
+{
+    IndexSnapshot *snapshot = malloc(sizeof(IndexSnapshot));
+    if (snapshot == NULL)
+    {
+        fprintf(stderr, "\nERROR: Memory allocation failed for index snapshot\n");
+        return NULL;
+    }
+
+    IndexSnapshot *current = snapshot_acquire(store);
+    int status = hashTable_clone(snapshot->hashTable, current->hashTable);
+    if (status == SUCCESS && docTable_clone(&snapshot->docs, &current->docs) == FAILURE)
+    {
+        free_hashTable(snapshot->hashTable);
+        status = FAILURE;
+    }
+    if (status == SUCCESS && termSketch_clone(&snapshot->sketch, &current->sketch) == FAILURE)
+    {
+        free_hashTable(snapshot->hashTable);
+        free_docTable(&snapshot->docs);
+        status = FAILURE;
+    }
+    snapshot_release(current);
+
+    if (status == FAILURE)
+    {
+        fprintf(stderr, "\nERROR: Memory allocation failed while copying the index\n");
+        free(snapshot);
+        return NULL;
+    }
+    snapshot->version = 0;
+    atomic_init(&snapshot->refCount, 1);
+    return snapshot;
+}
+
+/**
+ * Swaps in the new snapshot and drops the store's reference to the
+ * previous one; readers still holding it keep a consistent view.
+ */
+void snapshot_publish(SnapshotStore *store, IndexSnapshot *snapshot)
+{
+    pthread_mutex_lock(&store->lock);
+    IndexSnapshot *previous = store->current;
+    snapshot->version = store->nextVersion++;
+    store->current = snapshot;
+    pthread_mutex_unlock(&store->lock);
+
+    snapshot_release(previous);
+}
@@ -0,0 +1,86 @@
+/***********************************************************************
+ *  File name   : snapshot.h
+ *  Description : Header file for versioned index snapshots of the
+ *                Inverted Search Project.
+ *                A snapshot (hash table + document table) is never
+ *                modified once published. Readers pin the current
+ *                snapshot, writers build a new one (empty or cloned
+ *                from the current one) and publish it with a pointer
+ *                swap. A snapshot is freed when its last reader
+ *                releases it.
+ *
+ *                Functions:
+ *                - snapshotStore_init()
+ *                - snapshot_create()
+ *                - snapshot_clone()
+ *                - snapshot_acquire()
+ *                - snapshot_release()
+ *                - snapshot_publish()
+ *
+ ***********************************************************************/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "list.h"
+#include "docs.h"
+#include "stats.h"
+
+/* IndexSnapshot:
+ * One version of the index.
+ */
+typedef struct IndexSnapshot
+{
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    TermSketch sketch;         // Words counted while ingesting this version
+    int version;               // Set when published
+    atomic_int refCount;       // Readers + the store while it is current
+} IndexSnapshot;
+
+/* SnapshotStore:
+ * Holds the current snapshot.
+ */
+typedef struct SnapshotStore
+{
+    pthread_mutex_t lock;      // Guards current against a concurrent swap
+    IndexSnapshot *current;
+    int nextVersion;
+} SnapshotStore;
+
+/**
+ * Initializes the store with an empty version 0.
+ * Returns SUCCESS or FAILURE.
+ */
+int snapshotStore_init(SnapshotStore *store);
+
+/**
+ * Returns a new empty snapshot owned by the caller, or NULL.
+ */
+IndexSnapshot *snapshot_create(void);
+
+/**
+ * Returns a deep copy of the current snapshot owned by the caller, or NULL.
+ */
+IndexSnapshot *snapshot_clone(SnapshotStore *store);
+
+/**
+ * Pins and returns the current snapshot.
+ */
+IndexSnapshot *snapshot_acquire(SnapshotStore *store);
+
+/**
+ * Unpins a snapshot, freeing it if nobody uses it anymore.
+ */
+void snapshot_release(IndexSnapshot *snapshot);
+
+/**
+ * Makes a snapshot built by the caller the current one. The caller's
+ * reference moves to the store; the previous snapshot is released.
+ */
+void snapshot_publish(SnapshotStore *store, IndexSnapshot *snapshot);
+
+#endif
@@ -0,0 +1,546 @@
+/***********************************************************************
+ *  File name   : stats.c
+ *  Description : Implementation file for index statistics and term
+ *                analytics of the Inverted Search Project.
+ *                Bucket workers write into their own result slots,
+ *                which are combined afterwards, so the output does not
+ *                depend on the number of threads.
+ *
+ *                Functions:
+ *                - termSketch_init()
+ *                - termSketch_add()
+ *                - termSketch_clone()
+ *                - termSketch_top()
+ *                - termSketch_free()
+ *                - index_top_terms()
+ *                - print_index_stats()
+ *                - print_top_terms()
+ *                - print_unique_terms()
+ *
+ ***********************************************************************/
+
+#include "stats.h"
+#include "buffer.h"
+#include "parallel.h"
+
+#define SKETCH_SLOT_EMPTY -1
+#define SKETCH_SLOT_DELETED -2
+
+/* ----------- Space-Saving sketch ----------- */
+
+void termSketch_init(TermSketch *sketch, int capacity)
+{
+    sketch->heap = NULL;
+    sketch->count = 0;
+    sketch->capacity = capacity;
+    sketch->slots = NULL;
+    sketch->slotCount = 0;
+    sketch->tombstones = 0;
+    sketch->total = 0;
+}
+
+void termSketch_free(TermSketch *sketch)
+{
+    free(sketch->heap);
+    free(sketch->slots);
+    termSketch_init(sketch, sketch->capacity);
+}
+
+/**
+ * Returns the slot of word, or the slot where it should be inserted
+ * (the first deleted slot on its probe path, else the empty one).
+ */
+static int sketch_find_slot(TermSketch *sketch, const char *word, int *found)
+{
+    int mask = sketch->slotCount - 1;
+    int slot = (int)(term_hash(word) & mask), insert = SKETCH_SLOT_EMPTY;
+    *found = 0;
+    while (sketch->slots[slot] != SKETCH_SLOT_EMPTY)
+    {
+        int pos = sketch->slots[slot];
+        if (pos == SKETCH_SLOT_DELETED)
+        {
+            if (insert == SKETCH_SLOT_EMPTY)
+                insert = slot;
+        }
+        else if (strcmp(sketch->heap[pos].word, word) == 0)
+        {
+            *found = 1;
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return insert == SKETCH_SLOT_EMPTY ? slot : insert;
+}
+
+/**
+ * Re-inserts every counter into a clean word index.
+ */
+static void sketch_rebuild_slots(TermSketch *sketch)
+{
+    int found;
+    for (int i = 0; i < sketch->slotCount; i++)
+        sketch->slots[i] = SKETCH_SLOT_EMPTY;
+    sketch->tombstones = 0;
+    for (int pos = 0; pos < sketch->count; pos++)
+    {
+        int slot = sketch_find_slot(sketch, sketch->heap[pos].word, &found);
+        sketch->slots[slot] = pos;
+        sketch->heap[pos].slot = slot;
+    }
+}
+
+static void sketch_swap(TermSketch *sketch, int i, int j)
+{
+    TermCount temp = sketch->heap[i];
+    sketch->heap[i] = sketch->heap[j];
+    sketch->heap[j] = temp;
+    sketch->slots[sketch->heap[i].slot] = i;
+    sketch->slots[sketch->heap[j].slot] = j;
+}
+
+static void sketch_sift_up(TermSketch *sketch, int pos)
+{
+    while (pos > 0 && sketch->heap[(pos - 1) / 2].count > sketch->heap[pos].count)
+    {
+        sketch_swap(sketch, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void sketch_sift_down(TermSketch *sketch, int pos)
+{
+    for (;;)
+    {
+        int smallest = pos, left = 2 * pos + 1, right = left + 1;
+        if (left < sketch->count && sketch->heap[left].count < sketch->heap[smallest].count)
+            smallest = left;
+        if (right < sketch->count && sketch->heap[right].count < sketch->heap[smallest].count)
+            smallest = right;
+        if (smallest == pos)
+            return;
+        sketch_swap(sketch, pos, smallest);
+        pos = smallest;
+    }
+}
+
+/**
+ * Increments the counter of word. An untracked word takes over the
+ * smallest counter once the sketch is full (Space-Saving).
+ */
+int termSketch_add(TermSketch *sketch, const char *word, long long weight)
+{
+    if (sketch->heap == NULL)
+    {
+        int slotCount = 16;
+        while (slotCount < 2 * sketch->capacity)
+            slotCount *= 2;
+        sketch->heap = malloc(sketch->capacity * sizeof(TermCount));
+        sketch->slots = malloc(slotCount * sizeof(int));
+        if (sketch->heap == NULL || sketch->slots == NULL)
+        {
+            termSketch_free(sketch);
+            return FAILURE;
+        }
+        sketch->slotCount = slotCount;
+        sketch_rebuild_slots(sketch);
+    }
+    sketch->total += weight;
+
+    int found;
+    int slot = sketch_find_slot(sketch, word, &found);
+    if (found)
+    {
+        int pos = sketch->slots[slot];
+        sketch->heap[pos].count += weight;
+        sketch_sift_down(sketch, pos);
+        return SUCCESS;
+    }
+
+    if (sketch->slots[slot] == SKETCH_SLOT_DELETED)
+        sketch->tombstones--;
+    if (sketch->count < sketch->capacity)
+    {
+        int pos = sketch->count++;
+        TermCount *entry = &sketch->heap[pos];
+        snprintf(entry->word, MAX_WORD_LENGTH, "%s", word);
+        entry->count = weight;
+        entry->error = 0;
+        entry->slot = slot;
+        sketch->slots[slot] = pos;
+        sketch_sift_up(sketch, pos);
+    }
+    else
+    {
+        // Evict the smallest counter; the new word inherits its count as error
+        TermCount *entry = &sketch->heap[0];
+        sketch->slots[entry->slot] = SKETCH_SLOT_DELETED;
+        sketch->tombstones++;
+        snprintf(entry->word, MAX_WORD_LENGTH, "%s", word);
+        entry->error = entry->count;
+        entry->count += weight;
+        entry->slot = slot;
+        sketch->slots[slot] = 0;
+        sketch_sift_down(sketch, 0);
+    }
+
+    if (4 * (sketch->count + sketch->tombstones) > 3 * sketch->slotCount)
+        sketch_rebuild_slots(sketch);
+    return SUCCESS;
+}
+
+int termSketch_clone(TermSketch *dst, TermSketch *src)
+{
+    termSketch_init(dst, src->capacity);
+    dst->total = src->total;
+    if (src->heap == NULL)
+        return SUCCESS;
+    dst->heap = malloc(src->capacity * sizeof(TermCount));
+    dst->slots = malloc(src->slotCount * sizeof(int));
+    if (dst->heap == NULL || dst->slots == NULL)
+    {
+        termSketch_free(dst);
+        return FAILURE;
+    }
+    memcpy(dst->heap, src->heap, src->count * sizeof(TermCount));
+    memcpy(dst->slots, src->slots, src->slotCount * sizeof(int));
+    dst->count = src->count;
+    dst->slotCount = src->slotCount;
+    dst->tombstones = src->tombstones;
+    return SUCCESS;
+}
+
+/* Compare function ranking counters by count, then by word */
+static int compare_rank(const void *a, const void *b)
+{
+    const TermCount *x = a, *y = b;
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;
+    return strcmp(x->word, y->word);
+}
+
+int termSketch_top(TermSketch *sketch, TermCount *out, int n)
+{
+    TermCount *sorted = malloc((sketch->count + 1) * sizeof(TermCount));
+    if (sorted == NULL)
+        return FAILURE;
+    if (sketch->count > 0)
+        memcpy(sorted, sketch->heap, sketch->count * sizeof(TermCount));
+    qsort(sorted, sketch->count, sizeof(TermCount), compare_rank);
+    if (n > sketch->count)
+        n = sketch->count;
+    memcpy(out, sorted, n * sizeof(TermCount));
+    free(sorted);
+    return n;
+}
+
+/* ----------- Exact top-N ----------- */
+
+/* TopJob:
+ * Shared by the bucket workers of index_top_terms().
+ */
+typedef struct TopJob
+{
+    HashTable *hashTable;
+    int n;
+    TermCount *heaps;          // Bounded heap of every bucket, worst entry first
+    size_t start[MAX_HASH_SIZE];         // First heap entry of each bucket
+    int counts[MAX_HASH_SIZE];
+} TopJob;
+
+/* Returns the number of occurrences of a word over every file */
+static long long collection_frequency(MainNode *node)
+{
+    PostingCursor cursor;
+    int docId, wordCount;
+    long long total = 0;
+    postingCursor_init(&cursor, node);
+    while (postingCursor_next(&cursor, &docId, &wordCount))
+        total += wordCount;
+    return total;
+}
+
+/* Restores the "worst entry on top" order below pos */
+static void top_sift_down(TermCount *heap, int count, int pos)
+{
+    for (;;)
+    {
+        int worst = pos, left = 2 * pos + 1, right = left + 1;
+        if (left < count && compare_rank(&heap[left], &heap[worst]) > 0)
+            worst = left;
+        if (right < count && compare_rank(&heap[right], &heap[worst]) > 0)
+            worst = right;
+        if (worst == pos)
+            return;
+        TermCount temp = heap[pos];
+        heap[pos] = heap[worst];
+        heap[worst] = temp;
+        pos = worst;
+    }
+}
+
+/* Keeps the n best words of one bucket in a bounded heap */
+static int top_bucket(int index, void *arg)
+{
+    TopJob *job = arg;
+    TermCount *heap = job->heaps + job->start[index];
+    int count = 0;
+    for (MainNode *node = job->hashTable[index].link; node; node = node->mainLink)
+    {
+        TermCount entry;
+        snprintf(entry.word, MAX_WORD_LENGTH, "%s", node->word);
+        entry.count = collection_frequency(node);
+        entry.error = 0;
+        entry.slot = 0;
+        if (count < job->n)
+        {
+            // Sift the new entry up towards the root
+            int pos = count++;
+            heap[pos] = entry;
+            while (pos > 0 && compare_rank(&heap[pos], &heap[(pos - 1) / 2]) > 0)
+            {
+                TermCount temp = heap[pos];
+                heap[pos] = heap[(pos - 1) / 2];
+                heap[(pos - 1) / 2] = temp;
+                pos = (pos - 1) / 2;
+            }
+        }
+        else if (compare_rank(&entry, &heap[0]) < 0)
+        {
+            heap[0] = entry;
+            top_sift_down(heap, count, 0);
+        }
+    }
+    job->counts[index] = count;
+    return SUCCESS;
+}
+
+/**
+ * Takes the n best words of every bucket in parallel, then ranks the
+ * union of those candidates.
+ */
+int index_top_terms(HashTable hashTablle[MAX_HASH_SIZE], int n, TermCount *out)
+{
+    TopJob job;
+    job.hashTable = hashTablle;
+    job.n = n;
+
+    // A bucket never keeps more than min(n, its word count) candidates
+    size_t size = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        job.start[i] = size;
+        size += hashTablle[i].terms.size < n ? hashTablle[i].terms.size : n;
+    }
+    job.heaps = malloc((size + 1) * sizeof(TermCount));
+    if (job.heaps == NULL)
+        return FAILURE;
+    parallel_for(MAX_HASH_SIZE, get_thread_count(), top_bucket, &job);
+
+    // Move every bucket's candidates next to each other
+    int total = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        memmove(job.heaps + total, job.heaps + job.start[i], job.counts[i] * sizeof(TermCount));
+        total += job.counts[i];
+    }
+    qsort(job.heaps, total, sizeof(TermCount), compare_rank);
+    if (n > total)
+        n = total;
+    memcpy(out, job.heaps, n * sizeof(TermCount));
+    free(job.heaps);
+    return n;
+}
+
+/* ----------- Vocabulary statistics ----------- */
+
+/* VocabJob:
+ * Shared by the bucket workers of print_index_stats().
+ */
+typedef struct VocabJob
+{
+    HashTable *hashTable;
+    int docCount;
+    int *distinct[MAX_HASH_SIZE];        // Words of each file, per bucket
+    int *unique[MAX_HASH_SIZE];          // Words found only in that file, per bucket
+    long long *tokens[MAX_HASH_SIZE];    // Occurrences in each file, per bucket
+    int terms[MAX_HASH_SIZE];
+    int singleFileTerms[MAX_HASH_SIZE];
+} VocabJob;
+
+/* Counts the words of one bucket per file */
+static int vocab_bucket(int index, void *arg)
+{
+    VocabJob *job = arg;
+    if (job->hashTable[index].link == NULL || job->docCount == 0)
+        return SUCCESS;
+
+    int *distinct = calloc(job->docCount, sizeof(int));
+    int *unique = calloc(job->docCount, sizeof(int));
+    long long *tokens = calloc(job->docCount, sizeof(long long));
+    job->distinct[index] = distinct;
+    job->unique[index] = unique;
+    job->tokens[index] = tokens;
+    if (distinct == NULL || unique == NULL || tokens == NULL)
+        return FAILURE;
+
+    for (MainNode *node = job->hashTable[index].link; node; node = node->mainLink)
+    {
+        PostingCursor cursor;
+        int docId, wordCount, files = 0, lastDoc = 0;
+        postingCursor_init(&cursor, node);
+        while (postingCursor_next(&cursor, &docId, &wordCount))
+        {
+            distinct[docId]++;
+            tokens[docId] += wordCount;
+            lastDoc = docId;
+            files++;
+        }
+        job->terms[index]++;
+        if (files == 1)
+        {
+            unique[lastDoc]++;
+            job->singleFileTerms[index]++;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Sums the per-bucket counts and prints the collection totals followed
+ * by one line per file.
+ */
+void print_index_stats(HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs)
+{
+    if (docs->count == 0)
+    {
+        printf("\nINFO: DATABASE is empty\n");
+        return;
+    }
+    VocabJob job;
+    memset(&job, 0, sizeof(job));
+    job.hashTable = hashTablle;
+    job.docCount = docs->count;
+    int status = parallel_for(MAX_HASH_SIZE, get_thread_count(), vocab_bucket, &job);
+
+    int terms = 0, singleFileTerms = 0;
+    long long tokens = 0;
+    TextBuffer out;
+    buffer_init(&out);
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        terms += job.terms[i];
+        singleFileTerms += job.singleFileTerms[i];
+    }
+    for (int d = 0; d < docs->count && status == SUCCESS; d++)
+    {
+        long long docTokens = 0;
+        int distinct = 0, unique = 0;
+        for (int i = 0; i < MAX_HASH_SIZE; i++)
+        {
+            if (job.distinct[i] == NULL)
+                continue;
+            docTokens += job.tokens[i][d];
+            distinct += job.distinct[i][d];
+            unique += job.unique[i][d];
+        }
+        tokens += docTokens;
+        char line[128];
+        int length = snprintf(line, sizeof(line), "| %-20s%15lld%15d%15d        |\n", docs->names[d], docTokens, distinct, unique);
+        buffer_append(&out, line, length);
+    }
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        free(job.distinct[i]);
+        free(job.unique[i]);
+        free(job.tokens[i]);
+    }
+    if (status == FAILURE || out.failed)
+    {
+        fprintf(stderr, "\nERROR: Could not allocate memory for statistics\n");
+        buffer_free(&out);
+        return;
+    }
+
+    printf("\nFiles               : %d\n", docs->count);
+    printf("Distinct words      : %d\n", terms);
+    printf("Total words         : %lld\n", tokens);
+    printf("Words in one file   : %d\n", singleFileTerms);
+    printf("===============================================================================\n");
+    printf("| %-20s%15s%15s%15s        |\n", "File Name", "Words", "Distinct", "Unique");
+    printf("|-----------------------------------------------------------------------------|\n");
+    fflush(stdout);
+    fwrite(out.data, 1, out.length, stdout);
+    printf("===============================================================================\n");
+    buffer_free(&out);
+}
+
+/**
+ * Prints a ranked word list; sketch counts show their error bound.
+ */
+void print_top_terms(HashTable hashTablle[MAX_HASH_SIZE], TermSketch *sketch, int n, int useSketch)
+{
+    if (n < 1 || n > MAX_TOP_TERMS)
+    {
+        fprintf(stderr, "\nERROR: N must be between 1 and %d\n", MAX_TOP_TERMS);
+        return;
+    }
+    TermCount *top = malloc(n * sizeof(TermCount));
+    int count = top == NULL ? FAILURE : useSketch ? termSketch_top(sketch, top, n) : index_top_terms(hashTablle, n, top);
+    if (count == FAILURE)
+    {
+        fprintf(stderr, "\nERROR: Could not allocate memory for top words\n");
+        free(top);
+        return;
+    }
+
+    TextBuffer out;
+    buffer_init(&out);
+    for (int i = 0; i < count; i++)
+    {
+        char line[128];
+        int length = useSketch
+            ? snprintf(line, sizeof(line), "%6d. %-20s%12lld  (+/- %lld)\n", i + 1, top[i].word, top[i].count, top[i].error)
+            : snprintf(line, sizeof(line), "%6d. %-20s%12lld\n", i + 1, top[i].word, top[i].count);
+        buffer_append(&out, line, length);
+    }
+    if (useSketch)
+        printf("\nTop %d words seen while ingesting (%lld words in total):\n", count, sketch->total);
+    else
+        printf("\nTop %d words of the DATABASE:\n", count);
+    fflush(stdout);
+    if (out.length)
+        fwrite(out.data, 1, out.length, stdout);
+    buffer_free(&out);
+    free(top);
+}
+
+void print_unique_terms(HashTable hashTablle[MAX_HASH_SIZE], DocTable *docs, char *filename)
+{
+    int docId = docTable_find_id(docs, filename);
+    if (docId == FAILURE)
+    {
+        printf("\nFile \"%s\" not present in the DATABASE\n", filename);
+        return;
+    }
+
+    int found = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        for (MainNode *node = hashTablle[i].link; node; node = node->mainLink)
+        {
+            PostingCursor cursor;
+            int id, wordCount;
+            postingCursor_init(&cursor, node);
+            if (node->fileCount != 1 || !postingCursor_next(&cursor, &id, &wordCount) || id != docId)
+                continue;
+            if (found++ == 0)
+                printf("\nWords found only in '%s':\n", filename);
+            printf("%-20s (%d) Time\n", node->word, wordCount);
+        }
+    }
+    if (found == 0)
+        printf("\nEvery word of '%s' is present in another file\n", filename);
+    else
+        printf("(%d) word(s)\n", found);
+}
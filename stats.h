@@ -0,0 +1,113 @@
+/***********************************************************************
+ *  File name   : stats.h
+ *  Description : Header file for index statistics and term analytics
+ *                of the Inverted Search Project.
+ *                Exact statistics (collection frequency of every word,
+ *                top-N words, per-file vocabulary) are computed from
+ *                the index, one hash table bucket per worker thread.
+ *                A Space-Saving sketch is also fed with every word while
+ *                files and backups are ingested, so approximate top-N
+ *                counts are available at any time without a pass over
+ *                the index.
+ *
+ *                Functions:
+ *                - termSketch_init()
+ *                - termSketch_add()
+ *                - termSketch_clone()
+ *                - termSketch_top()
+ *                - termSketch_free()
+ *                - index_top_terms()
+ *                - print_index_stats()
+ *                - print_top_terms()
+ *                - print_unique_terms()
+ *
+ ***********************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "list.h"
+#include "docs.h"
+
+#define SKETCH_CAPACITY 4096             // Words tracked by the ingest sketch
+#define MAX_TOP_TERMS 100000             // Largest N accepted for top-N queries
+
+/* TermCount:
+ * A word and its (estimated) number of occurrences. For sketch entries
+ * the true count lies in [count - error, count].
+ */
+typedef struct TermCount
+{
+    char word[MAX_WORD_LENGTH];
+    long long count;
+    long long error;
+    int slot;                            // Sketch only: position in the word index
+} TermCount;
+
+/* TermSketch:
+ * Space-Saving summary: a min-heap of at most capacity counters plus an
+ * open-addressing index from word to heap position.
+ */
+typedef struct TermSketch
+{
+    TermCount *heap;                     // heap[0] holds the smallest count
+    int count;
+    int capacity;
+    int *slots;                          // Heap position, or a SKETCH_SLOT_* marker
+    int slotCount;                       // Power of two, at least 2 * capacity
+    int tombstones;
+    long long total;                     // Sum of every added weight
+} TermSketch;
+
+/**
+ * Initializes an empty sketch tracking up to capacity words.
+ * Memory is allocated on the first add.
+ */
+void termSketch_init(TermSketch *sketch, int capacity);
+
+/**
+ * Counts weight more occurrences of word. Returns SUCCESS or FAILURE.
+ */
+int termSketch_add(TermSketch *sketch, const char *word, long long weight);
+
+/**
+ * Stores a copy of src in dst. Returns SUCCESS or FAILURE.
+ */
+int termSketch_clone(TermSketch *dst, TermSketch *src);
+
+/**
+ * Writes the (up to) n largest counters to out, largest first.
+ * Returns the number written.
+ */
+int termSketch_top(TermSketch *sketch, TermCount *out, int n);
+
+/**
+ * Releases the sketch memory and empties it.
+ */
+void termSketch_free(TermSketch *sketch);
+
+/**
+ * Writes the n most frequent words of the index to out, largest
+ * collection frequency first (ties by word). Returns the number
+ * written, or FAILURE.
+ */
+int index_top_terms(HashTable hashTable[MAX_HASH_SIZE], int n, TermCount *out);
+
+/**
+ * Prints collection totals and the vocabulary of every file: tokens,
+ * distinct words and words found in no other file.
+ */
+void print_index_stats(HashTable hashTable[MAX_HASH_SIZE], DocTable *docs);
+
+/**
+ * Prints the n most frequent words, exactly from the index or
+ * approximately from the ingest sketch.
+ */
+void print_top_terms(HashTable hashTable[MAX_HASH_SIZE], TermSketch *sketch, int n, int useSketch);
+
+/**
+ * Prints the words that occur in filename and in no other file.
+ */
+void print_unique_terms(HashTable hashTable[MAX_HASH_SIZE], DocTable *docs, char *filename);
+
+#endif
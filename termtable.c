@@ -0,0 +1,195 @@
+/***********************************************************************
+ *  File name   : termtable.c
+ *  Description : Implementation file for the per-bucket term directory
+ *                of the Inverted Search Project.
+ *                Slots are grouped by TERM_GROUP_WIDTH. The low 7 bits
+ *                of a word's hash are its fingerprint, the remaining bits
+ *                select the first group to probe. A group is matched
+ *                with one SSE2 compare when available, otherwise with a
+ *                scalar loop.
+ *
+ *                Functions:
+ *                - term_hash()
+ *                - termTable_init()
+ *                - termTable_reserve()
+ *                - termTable_find()
+ *                - termTable_insert()
+ *                - termTable_free()
+ *
+ ***********************************************************************/
+
+#include "termtable.h"
+#include "list.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Returns a bitmask of the slots in the group whose control byte is tag.
+ */
+static unsigned int group_match(const unsigned char *ctrl, unsigned char tag)
+{
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+#else
+    unsigned int mask = 0;
+    for (int i = 0; i < TERM_GROUP_WIDTH; i++)
+    {
+        if (ctrl[i] == tag)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Places a hash/node pair in the first free slot of its probe sequence.
+ * The table must have room for it.
+ */
+static void place_slot(TermTable *table, unsigned long long hash, MainNode *node)
+{
+    int groupMask = table->capacity / TERM_GROUP_WIDTH - 1;
+    int group = (int)(hash >> 7) & groupMask;
+
+    for (int stride = 1; ; stride++)
+    {
+        int base = group * TERM_GROUP_WIDTH;
+        unsigned int empty = group_match(table->ctrl + base, TERM_CTRL_EMPTY);
+        if (empty)
+        {
+            int slot = base + __builtin_ctz(empty);
+            table->ctrl[slot] = (unsigned char)(hash & 0x7F);
+            table->hashes[slot] = hash;
+            table->nodes[slot] = node;
+            return;
+        }
+        group = (group + stride) & groupMask;
+    }
+}
+
+/**
+ * FNV-1a hash, finished with a multiply so the low (fingerprint)
+ * bits depend on every character.
+ */
+unsigned long long term_hash(const char *word)
+{
+    unsigned long long hash = 1469598103934665603ULL;
+    while (*word)
+    {
+        hash ^= (unsigned char)*word++;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 32;
+    hash *= 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Initializes an empty term table.
+ */
+void termTable_init(TermTable *table)
+{
+    table->ctrl = NULL;
+    table->hashes = NULL;
+    table->nodes = NULL;
+    table->size = 0;
+    table->capacity = 0;
+}
+
+/**
+ * Grows the table (keeping the load factor under 7/8) so that
+ * count terms fit. Existing slots are re-placed from the stored
+ * hashes, without touching the words.
+ */
+int termTable_reserve(TermTable *table, int count)
+{
+    int capacity = table->capacity ? table->capacity : TERM_GROUP_WIDTH;
+    while ((long)count * 8 > (long)capacity * 7)
+        capacity *= 2;
+    if (capacity == table->capacity)
+        return SUCCESS;
+
+    TermTable grown;
+    grown.ctrl = malloc(capacity);
+    grown.hashes = malloc(capacity * sizeof(unsigned long long));
+    grown.nodes = malloc(capacity * sizeof(MainNode *));
+    if (grown.ctrl == NULL || grown.hashes == NULL || grown.nodes == NULL)
+    {
+        free(grown.ctrl);
+        free(grown.hashes);
+        free(grown.nodes);
+        return FAILURE;
+    }
+    memset(grown.ctrl, TERM_CTRL_EMPTY, capacity);
+    grown.size = table->size;
+    grown.capacity = capacity;
+
+    for (int i = 0; i < table->capacity; i++)
+    {
+        if (table->ctrl[i] != TERM_CTRL_EMPTY)
+            place_slot(&grown, table->hashes[i], table->nodes[i]);
+    }
+
+    termTable_free(table);
+    *table = grown;
+    return SUCCESS;
+}
+
+/**
+ * Looks up a word. Only slots whose fingerprint and full hash
+ * match are compared against the MainNode's word.
+ */
+MainNode *termTable_find(TermTable *table, const char *word)
+{
+    if (table->size == 0)
+        return NULL;
+
+    unsigned long long hash = term_hash(word);
+    unsigned char tag = (unsigned char)(hash & 0x7F);
+    int groupMask = table->capacity / TERM_GROUP_WIDTH - 1;
+    int group = (int)(hash >> 7) & groupMask;
+
+    for (int stride = 1; stride <= groupMask + 1; stride++)
+    {
+        int base = group * TERM_GROUP_WIDTH;
+        unsigned int match = group_match(table->ctrl + base, tag);
+        while (match)
+        {
+            int slot = base + __builtin_ctz(match);
+            if (table->hashes[slot] == hash && strcmp(table->nodes[slot]->word, word) == 0)
+                return table->nodes[slot];
+            match &= match - 1;
+        }
+        // A free slot ends the probe sequence
+        if (group_match(table->ctrl + base, TERM_CTRL_EMPTY))
+            return NULL;
+        group = (group + stride) & groupMask;
+    }
+    return NULL;
+}
+
+/**
+ * Registers a new MainNode, growing the table if needed.
+ */
+int termTable_insert(TermTable *table, MainNode *node)
+{
+    if (termTable_reserve(table, table->size + 1) == FAILURE)
+        return FAILURE;
+
+    place_slot(table, term_hash(node->word), node);
+    table->size++;
+    return SUCCESS;
+}
+
+/**
+ * Releases the slot arrays.
+ */
+void termTable_free(TermTable *table)
+{
+    free(table->ctrl);
+    free(table->hashes);
+    free(table->nodes);
+    termTable_init(table);
+}
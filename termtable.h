@@ -0,0 +1,76 @@
+/***********************************************************************
+ *  File name   : termtable.h
+ *  Description : Header file for the term directory used by each hash
+ *                table bucket in the Inverted Search Project.
+ *                The directory is an open-addressing table kept as a
+ *                structure of arrays:
+ *                - ctrl   : 1-byte fingerprint per slot
+ *                - hashes : full 64-bit hash per slot
+ *                - nodes  : MainNode owning the term
+ *                A lookup compares a whole group of fingerprints at once
+ *                and only touches a MainNode when its fingerprint and
+ *                hash both match.
+ *
+ *                Functions:
+ *                - term_hash()
+ *                - termTable_init()
+ *                - termTable_reserve()
+ *                - termTable_find()
+ *                - termTable_insert()
+ *                - termTable_free()
+ *
+ ***********************************************************************/
+
+#ifndef TERMTABLE_H
+#define TERMTABLE_H
+
+#define TERM_GROUP_WIDTH 16      // Fingerprints compared per probe step
+#define TERM_CTRL_EMPTY 0x80     // Control byte of a free slot
+
+struct MainNode;
+
+/* TermTable:
+ * Maps a word to its MainNode without walking the bucket chain.
+ */
+typedef struct TermTable
+{
+    unsigned char *ctrl;             // 7-bit fingerprint per slot, TERM_CTRL_EMPTY if free
+    unsigned long long *hashes;      // Full hash per slot (used for rehashing and filtering)
+    struct MainNode **nodes;         // MainNode stored in the slot
+    int size;                        // Number of occupied slots
+    int capacity;                    // Number of slots (power of two, >= TERM_GROUP_WIDTH)
+} TermTable;
+
+/**
+ * Returns the 64-bit hash of a word.
+ */
+unsigned long long term_hash(const char *word);
+
+/**
+ * Initializes an empty term table (no memory is allocated).
+ */
+void termTable_init(TermTable *table);
+
+/**
+ * Grows the table so that count terms fit without rehashing.
+ * Returns SUCCESS or FAILURE.
+ */
+int termTable_reserve(TermTable *table, int count);
+
+/**
+ * Returns the MainNode holding word, or NULL if the word is not present.
+ */
+struct MainNode *termTable_find(TermTable *table, const char *word);
+
+/**
+ * Registers a MainNode whose word is not yet in the table.
+ * Returns SUCCESS or FAILURE.
+ */
+int termTable_insert(TermTable *table, struct MainNode *node);
+
+/**
+ * Releases the arrays owned by the table (MainNodes are not freed).
+ */
+void termTable_free(TermTable *table);
+
+#endif
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Builds and runs the tests of the Inverted Search Project.
+# Run from the project root: sh tests/run_tests.sh
+# Extra compiler flags come from CFLAGS, e.g.
+#   CFLAGS="-DDENSE_POSTING_THRESHOLD=3 -fsanitize=address,undefined" sh tests/run_tests.sh
+
+ROOT=$(pwd)
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT
+SOURCES=$(ls "$ROOT"/*.c | grep -v '/main\.c$')
+FAILED=0
+
+# run_test name sources...: builds tests/name.c and runs it inside $OUT
+run_test()
+{
+    name=$1
+    shift
+    if ! gcc -O2 -Wall -Wextra -I"$ROOT" $CFLAGS "$ROOT/tests/$name.c" "$@" -o "$OUT/$name" -lpthread; then
+        echo "$name: build failed"
+        FAILED=1
+    elif ! (cd "$OUT" && "./$name"); then
+        FAILED=1
+    fi
+}
+
+run_test test_postings "$ROOT/postings.c"
+run_test test_roaring $SOURCES
+run_test test_backup $SOURCES
+# A fan-in of 2 makes the smallest budget merge its runs in several passes
+run_test test_external -DEXTERNAL_MAX_FAN_IN=2 $SOURCES
+run_test test_packed $SOURCES
+run_test test_snapshot $SOURCES
+run_test test_filter $SOURCES
+run_test test_stats $SOURCES
+run_test test_export $SOURCES
+run_test test_dedup $SOURCES
+
+exit $FAILED
@@ -0,0 +1,257 @@
+/***********************************************************************
+ *  File name   : test_backup.c
+ *  Description : Tests for loading DATABASE backups in the Inverted
+ *                Search Project. Loading several backups that share
+ *                words (and files) plus new input files must give the
+ *                same postings as indexing every file at once, with a
+ *                single MainNode per word. Saving, and saving what was
+ *                loaded, must write the same bytes whatever the number
+ *                of threads.
+ *
+ *                Build : gcc -O2 -I. tests/test_backup.c $(ls *.c | grep -v main.c) -o test_backup -lpthread
+ *                Run   : ./test_backup   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "parallel.h"
+
+#define TEST_FILES 8
+#define TEST_VOCABULARY 400     // Distinct words of the generated files
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Writes file number n: a few words in every file, the others drawn
+ * from a shared vocabulary.
+ */
+static int write_file(char *filename, int n)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    fprintf(fp, "the and of file%d\n", n);
+    for (int i = 0; i < 300 + 50 * n; i++)
+    {
+        int r = rand() % TEST_VOCABULARY;
+        fprintf(fp, "%cw%d%c", 'a' + r % 26, (r * r) / TEST_VOCABULARY, i % 10 == 9 ? '\n' : ' ');
+    }
+    fclose(fp);
+    return SUCCESS;
+}
+
+/* Builds a FileList of files first..last (bk<n>.txt names) */
+static FileList *make_list(int first, int last)
+{
+    FileList *filelist = NULL;
+    char filename[MAX_FILENAME_LENGTH];
+    for (int n = first; n <= last; n++)
+    {
+        snprintf(filename, sizeof(filename), "bk%d.txt", n);
+        fileList_insert_last(&filelist, filename);
+    }
+    return filelist;
+}
+
+static void free_list(FileList *filelist)
+{
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+}
+
+/* Indexes the files into a new backup file and frees the list */
+static void write_backup(FileList *filelist, char *backup)
+{
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database for a backup");
+    save_database(hashTable, &docs, backup);
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    free_list(filelist);
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    return strcmp(a, b);
+}
+
+/**
+ * Writes "file=count" of every posting of word, sorted by file name,
+ * to text. Returns the number of MainNodes holding the word.
+ */
+static int describe_word(HashTable *hashTable, DocTable *docs, char *word, char *text, int size)
+{
+    int nodes = 0, length = 0;
+    char entries[TEST_FILES][40];
+    int count = 0;
+    int index = get_word_index(word);
+    for (MainNode *node = hashTable[index].link; node; node = node->mainLink)
+    {
+        if (strcmp(node->word, word) != 0)
+            continue;
+        nodes++;
+        PostingCursor cursor;
+        int docId, wordCount;
+        postingCursor_init(&cursor, node);
+        while (postingCursor_next(&cursor, &docId, &wordCount) && count < TEST_FILES)
+            snprintf(entries[count++], sizeof(entries[0]), "%s=%d", docs->names[docId], wordCount);
+    }
+    qsort(entries, count, sizeof(entries[0]), compare_entries);
+    text[0] = '\0';
+    for (int i = 0; i < count && length < size; i++)
+        length += snprintf(text + length, size - length, "%s ", entries[i]);
+    return nodes;
+}
+
+/* Compares every word of expected with the same word in actual */
+static void check_same_index(HashTable *expected, DocTable *expectedDocs, HashTable *actual, DocTable *actualDocs, const char *what)
+{
+    char want[TEST_FILES * 40], got[TEST_FILES * 40];
+    int words = 0, same = 1, single = 1, actualWords = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+    {
+        for (MainNode *node = expected[i].link; node; node = node->mainLink, words++)
+        {
+            describe_word(expected, expectedDocs, node->word, want, sizeof(want));
+            single &= describe_word(actual, actualDocs, node->word, got, sizeof(got)) == 1;
+            same &= strcmp(want, got) == 0;
+        }
+        for (MainNode *node = actual[i].link; node; node = node->mainLink)
+            actualWords++;
+    }
+    char message[120];
+    snprintf(message, sizeof(message), "%s: same postings for %d words", what, words);
+    check(same && words == actualWords, message);
+    snprintf(message, sizeof(message), "%s: one MainNode per word", what);
+    check(single, message);
+}
+
+/* Returns 1 if both files hold the same bytes */
+static int same_file(char *pathA, char *pathB)
+{
+    FILE *a = fopen(pathA, "r"), *b = fopen(pathB, "r");
+    int same = a != NULL && b != NULL, ca, cb;
+    while (same && ((ca = fgetc(a)) != EOF) | ((cb = fgetc(b)) != EOF))
+        same = ca == cb;
+    if (a)
+        fclose(a);
+    if (b)
+        fclose(b);
+    return same;
+}
+
+/**
+ * Saves the index, then loads and saves that backup again, with
+ * several thread counts; every file must match the one-thread save.
+ */
+static void check_thread_counts(HashTable *hashTable, DocTable *docs)
+{
+    const char *threads[] = {"1", "2", "3", "8", "16"};
+    char message[80];
+    setenv(THREADS_ENV, "1", 1);
+    save_database(hashTable, docs, "bk_t1.txt");
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        HashTable loaded[MAX_HASH_SIZE];
+        DocTable loadedDocs;
+        FileList *empty = NULL;
+        setenv(THREADS_ENV, threads[t], 1);
+        save_database(hashTable, docs, "bk_tn.txt");
+        snprintf(message, sizeof(message), "save with %s thread(s), same bytes", threads[t]);
+        check(same_file("bk_t1.txt", "bk_tn.txt"), message);
+
+        initialize_hashTable(loaded, MAX_HASH_SIZE);
+        initialize_docTable(&loadedDocs);
+        snprintf(message, sizeof(message), "load with %s thread(s)", threads[t]);
+        check(update_database(&empty, loaded, &loadedDocs, NULL, "bk_t1.txt") == SUCCESS, message);
+        save_database(loaded, &loadedDocs, "bk_tn.txt");
+        snprintf(message, sizeof(message), "load and save with %s thread(s), same bytes", threads[t]);
+        check(same_file("bk_t1.txt", "bk_tn.txt"), message);
+        free_hashTable(loaded);
+        free_docTable(&loadedDocs);
+    }
+    unsetenv(THREADS_ENV);
+}
+
+int main(void)
+{
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    srand(42);
+    for (int n = 1; n <= TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "bk%d.txt", n);
+        check(write_file(filename, n) == SUCCESS, "write input file");
+    }
+    write_backup(make_list(1, 4), "bk_a.txt");
+    write_backup(make_list(5, 7), "bk_b.txt");
+    // Files in the reverse order of their ids once loaded
+    FileList *reversed = make_list(5, 5);
+    fileList_insert_last(&reversed, "bk1.txt");
+    write_backup(reversed, "bk_c.txt");
+
+    // Everything indexed at once
+    HashTable expected[MAX_HASH_SIZE];
+    DocTable expectedDocs;
+    FileList *all = make_list(1, TEST_FILES);
+    initialize_hashTable(expected, MAX_HASH_SIZE);
+    initialize_docTable(&expectedDocs);
+    check(create_database(all, expected, &expectedDocs, NULL) == SUCCESS, "create_database for every file");
+
+    // Two backups sharing words, then the last file from the input list
+    HashTable loaded[MAX_HASH_SIZE];
+    DocTable loadedDocs;
+    FileList *input = make_list(TEST_FILES, TEST_FILES);
+    initialize_hashTable(loaded, MAX_HASH_SIZE);
+    initialize_docTable(&loadedDocs);
+    check(update_database(&input, loaded, &loadedDocs, NULL, "bk_a.txt") == SUCCESS, "load first backup");
+    check(update_database(&input, loaded, &loadedDocs, NULL, "bk_b.txt") == SUCCESS, "load second backup");
+    check_same_index(expected, &expectedDocs, loaded, &loadedDocs, "two backups and an input file");
+
+    // A backup of files already loaded (in another order) changes nothing
+    check(update_database(&input, loaded, &loadedDocs, NULL, "bk_c.txt") == SUCCESS, "load a backup of loaded files");
+    check_same_index(expected, &expectedDocs, loaded, &loadedDocs, "backup of loaded files");
+
+    check_thread_counts(expected, &expectedDocs);
+    check_thread_counts(loaded, &loadedDocs);
+
+    free_hashTable(expected);
+    free_hashTable(loaded);
+    free_docTable(&expectedDocs);
+    free_docTable(&loadedDocs);
+    free_list(all);
+    free_list(input);
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_backup: %d checks (DENSE_POSTING_THRESHOLD %d), %d failed\n", checks, DENSE_POSTING_THRESHOLD, failures);
+    return failures != 0;
+}
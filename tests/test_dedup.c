@@ -0,0 +1,226 @@
+/***********************************************************************
+ *  File name   : test_dedup.c
+ *  Description : Tests for the near-duplicate detection of the Inverted
+ *                Search Project. Of five files, a copy and a lightly
+ *                edited version of the first must form one group with
+ *                it: listed by print_near_duplicates(), shown as one
+ *                representative by search_words_collapsed() and skipped
+ *                at ingest when COLLAPSE_ENV is set. A packed file keeps
+ *                the signatures, so its index collapses the same way;
+ *                files loaded from a text backup have none, are never
+ *                collapsed and are reported.
+ *
+ *                Build : gcc -O2 -I. tests/test_dedup.c $(ls *.c | grep -v main.c) -o test_dedup -lpthread
+ *                Run   : ./test_dedup   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "dedup.h"
+#include "packed.h"
+
+#define TEST_FILES 5            // dd0, its copy dd1, its edit dd2, then two other files
+#define TEST_WORDS 300          // Words of each file
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Writes file number n: "common" then words of the text of file 0 (n
+ * up to 2, with a few words changed in file 2) or of its own text.
+ */
+static int write_file(char *filename, int n)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    fprintf(fp, "common");
+    for (int i = 0; i < TEST_WORDS; i++)
+    {
+        if (n == 2 && i % 100 == 50)
+            fprintf(fp, " edited%d", i);
+        else
+            fprintf(fp, " w%dx%d", n > 2 ? n : 0, i);
+        if (i % 12 == 11)
+            fprintf(fp, "\n");
+    }
+    fprintf(fp, "\n");
+    fclose(fp);
+    return SUCCESS;
+}
+
+/* Returns 1 if the file holds the given text */
+static int file_contains(char *path, const char *text)
+{
+    char line[512];
+    int found = 0;
+    FILE *fp = fopen(path, "r");
+    while (fp && !found && fgets(line, sizeof(line), fp))
+        found = strstr(line, text) != NULL;
+    if (fp)
+        fclose(fp);
+    return found;
+}
+
+/* Runs a collapsed search of "common" with stdout and stderr sent to path */
+static void search_to_file(HashTable *hashTable, DocTable *docs, char *path)
+{
+    char words[1][MAX_WORD_LENGTH] = {"common"};
+    fflush(stdout);
+    fflush(stderr);
+    if (freopen(path, "w", stdout) == NULL)
+        return;
+    int errors = dup(STDERR_FILENO);
+    dup2(STDOUT_FILENO, STDERR_FILENO);
+    search_words_collapsed(hashTable, docs, words, 1, 0);
+    fflush(stdout);
+    fflush(stderr);
+    dup2(errors, STDERR_FILENO);
+    close(errors);
+    freopen("/dev/null", "w", stdout);
+}
+
+/* Lists the near-duplicates with stdout and stderr sent to path */
+static void list_to_file(DocTable *docs, char *path)
+{
+    fflush(stdout);
+    fflush(stderr);
+    if (freopen(path, "w", stdout) == NULL)
+        return;
+    int errors = dup(STDERR_FILENO);
+    dup2(STDOUT_FILENO, STDERR_FILENO);
+    print_near_duplicates(docs, NEAR_DUPLICATE_THRESHOLD);
+    fflush(stdout);
+    fflush(stderr);
+    dup2(errors, STDERR_FILENO);
+    close(errors);
+    freopen("/dev/null", "w", stdout);
+}
+
+static void free_files(FileList *filelist)
+{
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+}
+
+int main(void)
+{
+    FileList *filelist = NULL, *empty = NULL, *single = NULL;
+    HashTable hashTable[MAX_HASH_SIZE], backup[MAX_HASH_SIZE], packed[MAX_HASH_SIZE];
+    DocTable docs, backupDocs, packedDocs;
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    unsetenv(COLLAPSE_ENV);
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "dd%d.txt", n);
+        check(write_file(filename, n) == SUCCESS, "write input file");
+        fileList_insert_last(&filelist, filename);
+    }
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database");
+    int signedFiles = docs.count == TEST_FILES;
+    for (int d = 0; signedFiles && d < docs.count; d++)
+        signedFiles = !minhash_is_empty(docs.signatures[d]);
+    check(signedFiles, "indexed files have a signature");
+
+    // Files 0 to 2 form the only group
+    list_to_file(&docs, "dd_list.out");
+    check(file_contains("dd_list.out", "1 group(s) of near-duplicate files"), "listing finds one group");
+    check(file_contains("dd_list.out", "Group 1 (3 files):") && file_contains("dd_list.out", "'dd2.txt'") &&
+          !file_contains("dd_list.out", "'dd3.txt'"), "group holds files 0 to 2 only");
+    check(!file_contains("dd_list.out", "without a signature"), "no report when every file is signed");
+    search_to_file(hashTable, &docs, "dd_search.out");
+    check(file_contains("dd_search.out", "present in (5) file, 3 after collapsing"), "search collapses to three files");
+    check(file_contains("dd_search.out", "'dd0.txt' (+2 near-duplicate(s): 'dd1.txt' 'dd2.txt')"), "first file represents its group");
+    check(file_contains("dd_search.out", "In File : 'dd3.txt'\n") && file_contains("dd_search.out", "In File : 'dd4.txt'\n"),
+          "distinct files are listed alone");
+
+    // A text backup has no signatures: nothing is collapsed and the files are reported
+    save_database(hashTable, &docs, "dd_backup.txt");
+    initialize_hashTable(backup, MAX_HASH_SIZE);
+    initialize_docTable(&backupDocs);
+    check(update_database(&empty, backup, &backupDocs, NULL, "dd_backup.txt") == SUCCESS, "load text backup");
+    search_to_file(backup, &backupDocs, "dd_search.out");
+    check(file_contains("dd_search.out", "present in (5) file, 5 after collapsing"), "backup files are not collapsed");
+    check(file_contains("dd_search.out", "5 file(s) loaded without a signature"), "collapsed search reports unsigned files");
+    list_to_file(&backupDocs, "dd_list.out");
+    check(file_contains("dd_list.out", "No near-duplicate files") &&
+          file_contains("dd_list.out", "5 file(s) loaded without a signature"), "listing reports unsigned files");
+
+    // A packed file keeps the signatures
+    check(save_packed_database(hashTable, &docs, "dd_packed.txt") == SUCCESS, "save packed file");
+    initialize_hashTable(packed, MAX_HASH_SIZE);
+    initialize_docTable(&packedDocs);
+    check(update_database_packed(&empty, packed, &packedDocs, NULL, "dd_packed.txt") == SUCCESS, "load packed file");
+    int same = packedDocs.count == docs.count;
+    for (int d = 0; same && d < docs.count; d++)
+    {
+        int id = docTable_find_id(&packedDocs, docs.names[d]);
+        same = id != FAILURE && memcmp(packedDocs.signatures[id], docs.signatures[d], sizeof(docs.signatures[d])) == 0;
+    }
+    check(same, "packed file keeps the signatures");
+    search_to_file(packed, &packedDocs, "dd_search.out");
+    check(file_contains("dd_search.out", "present in (5) file, 3 after collapsing") &&
+          !file_contains("dd_search.out", "without a signature"), "packed files collapse like indexed ones");
+
+    // A lone signed file is its own group
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    fileList_insert_last(&single, "dd3.txt");
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(single, hashTable, &docs, NULL) == SUCCESS, "index a single file");
+    search_to_file(hashTable, &docs, "dd_search.out");
+    check(file_contains("dd_search.out", "present in (1) file, 1 after collapsing"), "single file search");
+
+    // Near-duplicates skipped at ingest never reach the index
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    setenv(COLLAPSE_ENV, "1", 1);
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database collapsing at ingest");
+    check(docs.count == 3 && docTable_find_id(&docs, "dd1.txt") == FAILURE && docTable_find_id(&docs, "dd2.txt") == FAILURE,
+          "copies of file 0 skipped at ingest");
+    unsetenv(COLLAPSE_ENV);
+
+    free_hashTable(hashTable);
+    free_hashTable(backup);
+    free_hashTable(packed);
+    free_docTable(&docs);
+    free_docTable(&backupDocs);
+    free_docTable(&packedDocs);
+    free_files(filelist);
+    free_files(single);
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_dedup: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
@@ -0,0 +1,231 @@
+/***********************************************************************
+ *  File name   : test_export.c
+ *  Description : Tests for the streaming export of the Inverted Search
+ *                Project. A JSONL export holds one line per word in
+ *                word order; the pages of an export (limit and page, or
+ *                offset and limit) must be consecutive slices of the
+ *                full export, a word range must export the words inside
+ *                it, and a page past the end, even one whose position
+ *                overflows a long, must be empty.
+ *
+ *                Build : gcc -O2 -I. tests/test_export.c $(ls *.c | grep -v main.c) -o test_export -lpthread
+ *                Run   : ./test_export   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "export.h"
+
+#define TEST_FILES 3
+#define TEST_VOCABULARY 1500    // Distinct words of the generated files
+#define TEST_LINE 4096          // Longest JSONL line read back
+#define TEST_PAGE 37            // Page size of the paged exports
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/* Writes file number n: words drawn from a shared vocabulary */
+static int write_file(char *filename, int n, int words)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    for (int i = 0; i < words; i++)
+    {
+        int w = (rand() % TEST_VOCABULARY + n * 100) % TEST_VOCABULARY;
+        fprintf(fp, "%c%cx%d%c", 'a' + w % 26, 'a' + w / 26 % 26, w, i % 12 == 11 ? '\n' : ' ');
+    }
+    fclose(fp);
+    return SUCCESS;
+}
+
+/**
+ * Exports with the options of text (JSONL) to path.
+ * Returns SUCCESS or FAILURE.
+ */
+static int export_to(HashTable *hashTable, DocTable *docs, const char *text, char *path)
+{
+    char options[200];
+    ExportOptions exportOptions;
+    snprintf(options, sizeof(options), "%s", text);
+    exportOptions_init(&exportOptions);
+    exportOptions.format = EXPORT_JSONL;
+    if (exportOptions_parse(&exportOptions, options) == FAILURE)
+        return FAILURE;
+    return export_database(hashTable, docs, &exportOptions, path);
+}
+
+/**
+ * Reads the lines of a file into one allocation (freed with free(*data)).
+ * Returns the count, or FAILURE.
+ */
+static int read_lines(char *path, char ***lines, char **data)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return FAILURE;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    *data = malloc(size + 1);
+    *lines = malloc((size + 1) * sizeof(char *));
+    if (*data == NULL || *lines == NULL || fread(*data, 1, size, fp) != (size_t)size)
+    {
+        fclose(fp);
+        free(*data);
+        free(*lines);
+        return FAILURE;
+    }
+    fclose(fp);
+    (*data)[size] = '\0';
+    int count = 0;
+    for (char *line = strtok(*data, "\n"); line; line = strtok(NULL, "\n"))
+        (*lines)[count++] = line;
+    return count;
+}
+
+/**
+ * Checks that the export of text is lines [first, first + count) of
+ * the full export.
+ */
+static void check_slice(HashTable *hashTable, DocTable *docs, char **full, int first, int count, const char *text)
+{
+    char **lines, *data, message[300];
+    snprintf(message, sizeof(message), "export '%s'", text);
+    if (export_to(hashTable, docs, text, "ex_part.txt") == FAILURE)
+    {
+        check(0, message);
+        return;
+    }
+    int n = read_lines("ex_part.txt", &lines, &data);
+    int same = n == count;
+    for (int i = 0; same && i < n; i++)
+        same = strcmp(lines[i], full[first + i]) == 0;
+    snprintf(message, sizeof(message), "export '%s' is lines %d to %d of the full export", text, first, first + count);
+    check(same, message);
+    if (n != FAILURE)
+    {
+        free(lines);
+        free(data);
+    }
+}
+
+/* Returns the word of a JSONL line in word (empty if not found) */
+static void line_word(const char *line, char *word)
+{
+    word[0] = '\0';
+    sscanf(line, "{\"word\":\"%19[^\"]\"", word);
+}
+
+int main(void)
+{
+    FileList *filelist = NULL;
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    char filename[MAX_FILENAME_LENGTH], text[200], **full, *fullData;
+
+    // The index reports progress on stdout and the export on stderr, keep them for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO), errors = dup(STDERR_FILENO);
+    if (console == -1 || errors == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    srand(42);
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "ex%d.txt", n);
+        check(write_file(filename, n, 3000 + 2000 * n) == SUCCESS, "write input file");
+        fileList_insert_last(&filelist, filename);
+    }
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database");
+    fflush(stderr);
+    freopen("/dev/null", "w", stderr);
+
+    // The full export has every word once, in order
+    check(export_to(hashTable, &docs, "-", "ex_full.txt") == SUCCESS, "full export");
+    int total = read_lines("ex_full.txt", &full, &fullData);
+    int words = 0;
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        for (MainNode *node = hashTable[i].link; node; node = node->mainLink)
+            words++;
+    int ordered = total == words;
+    char previous[MAX_WORD_LENGTH] = "", word[MAX_WORD_LENGTH];
+    for (int i = 0; ordered && i < total; i++)
+    {
+        line_word(full[i], word);
+        ordered = word[0] && strcmp(previous, word) < 0;
+        strcpy(previous, word);
+    }
+    check(ordered, "full export has every word once, in order");
+
+    if (total > 2 * TEST_PAGE)
+    {
+        // Pages are consecutive slices, up to an empty one past the end
+        for (int page = 1; (page - 1) * TEST_PAGE <= total; page++)
+        {
+            int first = (page - 1) * TEST_PAGE;
+            snprintf(text, sizeof(text), "limit=%d page=%d", TEST_PAGE, page);
+            check_slice(hashTable, &docs, full, first, total - first < TEST_PAGE ? total - first : TEST_PAGE, text);
+        }
+        snprintf(text, sizeof(text), "offset=%d limit=%d", TEST_PAGE + 3, TEST_PAGE);
+        check_slice(hashTable, &docs, full, TEST_PAGE + 3, TEST_PAGE, text);
+        snprintf(text, sizeof(text), "offset=%d", total - 5);
+        check_slice(hashTable, &docs, full, total - 5, 5, text);
+        snprintf(text, sizeof(text), "offset=3 limit=%d page=2", TEST_PAGE);
+        check_slice(hashTable, &docs, full, 3 + TEST_PAGE, TEST_PAGE, text);
+
+        // Word range: from is inclusive, to is exclusive
+        char from[MAX_WORD_LENGTH], to[MAX_WORD_LENGTH];
+        line_word(full[TEST_PAGE], from);
+        line_word(full[2 * TEST_PAGE], to);
+        snprintf(text, sizeof(text), "from=%s to=%s", from, to);
+        check_slice(hashTable, &docs, full, TEST_PAGE, TEST_PAGE, text);
+        snprintf(text, sizeof(text), "from=%s to=%s limit=5 page=3", from, to);
+        check_slice(hashTable, &docs, full, TEST_PAGE + 10, 5, text);
+        snprintf(text, sizeof(text), "from=%s to=%s", to, from);
+        check_slice(hashTable, &docs, full, 0, 0, text);
+    }
+
+    // Pages whose position overflows a long are past the end
+    check_slice(hashTable, &docs, full, 0, 0, "limit=2 page=4611686018427387905");
+    check_slice(hashTable, &docs, full, 0, 0, "limit=9223372036854775807 page=9223372036854775807");
+    check_slice(hashTable, &docs, full, 0, 0, "offset=9223372036854775807 limit=9223372036854775807");
+    check_slice(hashTable, &docs, full, 0, 0, "offset=9223372036854775807 limit=1 page=2");
+
+    if (total != FAILURE)
+    {
+        free(full);
+        free(fullData);
+    }
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(console, STDOUT_FILENO);
+    dup2(errors, STDERR_FILENO);
+    printf("test_export: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
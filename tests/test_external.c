@@ -0,0 +1,208 @@
+/***********************************************************************
+ *  File name   : test_external.c
+ *  Description : Tests for the low-memory build of the Inverted Search
+ *                Project. create_database_external() must write the
+ *                same DATABASE lines as create_database() followed by
+ *                save_database() (lines are ordered by word inside a
+ *                bucket instead of by first appearance), whether the
+ *                tuples fit in one run or are merged from several, and
+ *                its backup must load back to the same index. Built
+ *                with a small EXTERNAL_MAX_FAN_IN, the runs go through
+ *                intermediate merge passes.
+ *
+ *                Build : gcc -O2 -I. -DEXTERNAL_MAX_FAN_IN=2 tests/test_external.c $(ls *.c | grep -v main.c) -o test_external -lpthread
+ *                Run   : ./test_external   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "external.h"
+
+#define TEST_FILES 6
+#define TEST_VOCABULARY 3000    // Distinct words of the generated files
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Writes file number n: words drawn from a shared vocabulary (some
+ * starting with a digit or a symbol), skewed so a few are in every
+ * file. The last file holds a single word.
+ */
+static int write_file(char *filename, int n, int words)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    if (n == TEST_FILES - 1)
+        words = 1;
+    for (int i = 0; i < words; i++)
+    {
+        int r = rand() % TEST_VOCABULARY;
+        int w = (r * r) / TEST_VOCABULARY;          // Small numbers are frequent
+        const char *prefix = w % 7 == 0 ? "9" : w % 11 == 0 ? "_" : "";
+        fprintf(fp, "%s%c%cword%d%c", prefix, 'a' + w % 26, 'a' + w / 26 % 26, w, i % 12 == 11 ? '\n' : ' ');
+    }
+    fclose(fp);
+    return SUCCESS;
+}
+
+static int compare_lines(const void *x, const void *y)
+{
+    return strcmp(*(char *const *)x, *(char *const *)y);
+}
+
+/**
+ * Reads the lines of a file sorted, in *lines (one allocation, freed
+ * with free(*data)). Returns the count, or FAILURE.
+ */
+static int read_sorted_lines(char *filename, char ***lines, char **data)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return FAILURE;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    *data = malloc(size + 1);
+    *lines = malloc((size + 1) * sizeof(char *));
+    if (*data == NULL || *lines == NULL || fread(*data, 1, size, fp) != (size_t)size)
+    {
+        fclose(fp);
+        free(*data);
+        free(*lines);
+        return FAILURE;
+    }
+    fclose(fp);
+    (*data)[size] = '\0';
+    int count = 0;
+    for (char *line = strtok(*data, "\n"); line; line = strtok(NULL, "\n"))
+        (*lines)[count++] = line;
+    qsort(*lines, count, sizeof(char *), compare_lines);
+    return count;
+}
+
+/**
+ * Reads the run and merge pass counts of the last external build from
+ * its INFO line in the log. Returns SUCCESS or FAILURE.
+ */
+static int read_merge_report(char *log, int *runs, int *passes)
+{
+    char line[512];
+    int found = FAILURE;
+    fflush(stdout);
+    FILE *fp = fopen(log, "r");
+    if (fp == NULL)
+        return FAILURE;
+    while (fgets(line, sizeof(line), fp))
+    {
+        char *report = strstr(line, " using ");
+        if (strncmp(line, "INFO: Database written to", 25) == 0 && report &&
+            sscanf(report, " using %d run(s) in %d merge pass(es)", runs, passes) == 2)
+            found = SUCCESS;
+    }
+    fclose(fp);
+    return found;
+}
+
+/* Checks that two DATABASE files hold the same lines */
+static void check_same_lines(char *expected, char *actual, const char *what)
+{
+    char **a, **b, *dataA, *dataB;
+    int na = read_sorted_lines(expected, &a, &dataA);
+    int nb = read_sorted_lines(actual, &b, &dataB);
+    int same = na > 1 && na == nb;
+    for (int i = 0; same && i < na; i++)
+        same = strcmp(a[i], b[i]) == 0;
+    check(same, what);
+    if (na != FAILURE)
+    {
+        free(a);
+        free(dataA);
+    }
+    if (nb != FAILURE)
+    {
+        free(b);
+        free(dataB);
+    }
+}
+
+int main(void)
+{
+    FileList *filelist = NULL, *empty = NULL;
+    HashTable hashTable[MAX_HASH_SIZE], loaded[MAX_HASH_SIZE];
+    DocTable docs, loadedDocs;
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The builds report progress on stdout, logged to read the merge passes
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("ext_log.txt", "w", stdout) == NULL)
+        return 1;
+
+    srand(42);
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "ext%d.txt", n);
+        check(write_file(filename, n, 12000 + 3000 * n) == SUCCESS, "write input file");
+        fileList_insert_last(&filelist, filename);
+    }
+
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database");
+    save_database(hashTable, &docs, "ext_mem.txt");
+
+    // One run with the default budget, several runs merged with the smallest one
+    check(create_database_external(filelist, "ext_one.txt", DEFAULT_MEMORY_BUDGET_MB) == SUCCESS, "external build, one run");
+    check_same_lines("ext_mem.txt", "ext_one.txt", "external build, one run, same lines");
+    int runs = 0, passes = 0;
+    check(read_merge_report("ext_log.txt", &runs, &passes) == SUCCESS && runs == 1 && passes == 1, "external build, one run, one pass");
+    check(create_database_external(filelist, "ext_many.txt", MIN_MEMORY_BUDGET_MB) == SUCCESS, "external build, many runs");
+    check_same_lines("ext_mem.txt", "ext_many.txt", "external build, many runs, same lines");
+    check(read_merge_report("ext_log.txt", &runs, &passes) == SUCCESS && runs > 1, "external build, many runs reported");
+#ifdef EXTERNAL_MAX_FAN_IN
+    // Each pass divides the runs by the fan-in until the last merge can read them all
+    int expected = 1;
+    for (int left = runs; left > EXTERNAL_MAX_FAN_IN; left = (left + EXTERNAL_MAX_FAN_IN - 1) / EXTERNAL_MAX_FAN_IN)
+        expected++;
+    check(expected > 2 && passes == expected, "external build, intermediate merge passes");
+#endif
+
+    // The external backup loads back to the same index
+    initialize_hashTable(loaded, MAX_HASH_SIZE);
+    initialize_docTable(&loadedDocs);
+    check(update_database(&empty, loaded, &loadedDocs, NULL, "ext_many.txt") == SUCCESS, "load external backup");
+    save_database(loaded, &loadedDocs, "ext_load.txt");
+    check_same_lines("ext_mem.txt", "ext_load.txt", "loaded external backup, same lines");
+
+    free_hashTable(hashTable);
+    free_hashTable(loaded);
+    free_docTable(&docs);
+    free_docTable(&loadedDocs);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_external: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
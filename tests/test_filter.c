@@ -0,0 +1,192 @@
+/***********************************************************************
+ *  File name   : test_filter.c
+ *  Description : Tests for the metadata filters of the Inverted Search
+ *                Project. Filters on the size, mtime and token count of
+ *                indexed files must select the expected files. A packed
+ *                file keeps the metadata, so the index loaded from it
+ *                filters the same way. Files loaded from a text backup
+ *                have none: they fail the metadata conditions, are
+ *                counted by docFilter_unknown_count() and reported by
+ *                the filtered search.
+ *
+ *                Build : gcc -O2 -I. tests/test_filter.c $(ls *.c | grep -v main.c) -o test_filter -lpthread
+ *                Run   : ./test_filter   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "filter.h"
+#include "packed.h"
+
+#define TEST_FILES 4            // File n holds 5 << n words
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/* Writes file number n: "apple" then 5 << n - 1 other words */
+static int write_file(char *filename, int n)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    fprintf(fp, "apple");
+    for (int i = 1; i < 5 << n; i++)
+        fprintf(fp, " word%d", i % 7);
+    fprintf(fp, "\n");
+    fclose(fp);
+    return SUCCESS;
+}
+
+/**
+ * Applies the conditions of text and returns the passing ids as a bit
+ * mask (bit n for file fltn.txt), or -1 if the filter fails.
+ */
+static int filter_mask(DocTable *docs, const char *text, int *unknown)
+{
+    char conditions[100];
+    unsigned int ids[TEST_FILES + 1];
+    DocFilter filter;
+    snprintf(conditions, sizeof(conditions), "%s", text);
+    docFilter_init(&filter);
+    if (docFilter_parse(&filter, conditions) == FAILURE)
+        return -1;
+    int count = docFilter_apply(&filter, docs, ids);
+    if (count == FAILURE)
+        return -1;
+    *unknown = docFilter_unknown_count(&filter, docs);
+    int mask = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int n = -1;
+        sscanf(docs->names[ids[i]], "flt%d.txt", &n);
+        mask |= 1 << n;
+    }
+    return mask;
+}
+
+/* Returns 1 if the file holds the given text */
+static int file_contains(char *path, const char *text)
+{
+    char line[512];
+    int found = 0;
+    FILE *fp = fopen(path, "r");
+    while (fp && !found && fgets(line, sizeof(line), fp))
+        found = strstr(line, text) != NULL;
+    if (fp)
+        fclose(fp);
+    return found;
+}
+
+/* Runs a filtered search of "apple" with stdout sent to path */
+static void search_to_file(HashTable *hashTable, DocTable *docs, const char *text, char *path)
+{
+    char conditions[100], words[1][MAX_WORD_LENGTH] = {"apple"};
+    DocFilter filter;
+    snprintf(conditions, sizeof(conditions), "%s", text);
+    docFilter_init(&filter);
+    docFilter_parse(&filter, conditions);
+    fflush(stdout);
+    if (freopen(path, "w", stdout) == NULL)
+        return;
+    search_words_filtered(hashTable, docs, words, 1, 1, &filter);
+    fflush(stdout);
+    freopen("/dev/null", "w", stdout);
+}
+
+int main(void)
+{
+    FileList *filelist = NULL, *empty = NULL;
+    HashTable hashTable[MAX_HASH_SIZE], backup[MAX_HASH_SIZE], packed[MAX_HASH_SIZE];
+    DocTable docs, backupDocs, packedDocs;
+    char filename[MAX_FILENAME_LENGTH], text[100];
+    int unknown;
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "flt%d.txt", n);
+        check(write_file(filename, n) == SUCCESS, "write input file");
+        fileList_insert_last(&filelist, filename);
+    }
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database");
+
+    // Metadata of indexed files
+    int tokens = 1;
+    for (int n = 0; n < TEST_FILES; n++)
+        tokens &= docs.tokenCounts[n] == 5 << n && docs.sizes[n] > 0 && docs.mtimes[n] != DOC_UNKNOWN_TIME;
+    check(tokens, "indexed files have their metadata");
+    check(filter_mask(&docs, "tokens>=10", &unknown) == 0xE && unknown == 0, "tokens>=10 selects files 1 to 3");
+    check(filter_mask(&docs, "tokens>5 tokens<40", &unknown) == 0x6, "tokens range selects files 1 and 2");
+    snprintf(text, sizeof(text), "size<=%lld", docs.sizes[1]);
+    check(filter_mask(&docs, text, &unknown) == 0x3, "size bound selects files 0 and 1");
+    snprintf(text, sizeof(text), "mtime>=%lld", docs.mtimes[0]);
+    check(filter_mask(&docs, text, &unknown) != 0, "mtime bound selects files");
+    check(filter_mask(&docs, "prefix=flt2", &unknown) == 0x4, "prefix selects file 2");
+
+    // A text backup has no metadata: the files are skipped and counted
+    save_database(hashTable, &docs, "flt_backup.txt");
+    initialize_hashTable(backup, MAX_HASH_SIZE);
+    initialize_docTable(&backupDocs);
+    check(update_database(&empty, backup, &backupDocs, NULL, "flt_backup.txt") == SUCCESS, "load text backup");
+    check(filter_mask(&backupDocs, "tokens>=10", &unknown) == 0 && unknown == TEST_FILES, "backup files skipped by tokens and counted");
+    check(filter_mask(&backupDocs, "prefix=flt1 size>0", &unknown) == 0 && unknown == 1, "unknown count limited to the prefix");
+    check(filter_mask(&backupDocs, "prefix=flt1", &unknown) == 0x2 && unknown == 0, "prefix needs no metadata");
+    search_to_file(backup, &backupDocs, "tokens>=10", "flt_search.out");
+    check(file_contains("flt_search.out", "4 file(s) loaded without metadata"), "filtered search reports skipped files");
+    search_to_file(hashTable, &docs, "tokens>=10", "flt_search.out");
+    check(!file_contains("flt_search.out", "without metadata"), "no report when metadata is known");
+
+    // A packed file keeps the metadata
+    check(save_packed_database(hashTable, &docs, "flt_packed.txt") == SUCCESS, "save packed file");
+    initialize_hashTable(packed, MAX_HASH_SIZE);
+    initialize_docTable(&packedDocs);
+    check(update_database_packed(&empty, packed, &packedDocs, NULL, "flt_packed.txt") == SUCCESS, "load packed file");
+    int same = packedDocs.count == docs.count;
+    for (int d = 0; same && d < docs.count; d++)
+    {
+        int id = docTable_find_id(&packedDocs, docs.names[d]);
+        same = id != FAILURE && packedDocs.sizes[id] == docs.sizes[d] && packedDocs.mtimes[id] == docs.mtimes[d] &&
+               packedDocs.tokenCounts[id] == docs.tokenCounts[d];
+    }
+    check(same, "packed file keeps the metadata");
+    check(filter_mask(&packedDocs, "tokens>=10", &unknown) == 0xE && unknown == 0, "packed files filter like indexed ones");
+
+    free_hashTable(hashTable);
+    free_hashTable(backup);
+    free_hashTable(packed);
+    free_docTable(&docs);
+    free_docTable(&backupDocs);
+    free_docTable(&packedDocs);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_filter: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
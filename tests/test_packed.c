@@ -0,0 +1,260 @@
+/***********************************************************************
+ *  File name   : test_packed.c
+ *  Description : Tests for the packed database file of the Inverted
+ *                Search Project. For every word of an in-memory index
+ *                (and for absent words before, between and after the
+ *                blocks), packedIndex_search() must print the same
+ *                result as search_word(), and so must the index loaded
+ *                back with update_database_packed(). An empty index
+ *                must pack, open and load as well. A packed file loaded
+ *                into an index that already has some of its words and
+ *                files must give the index of all the files, with one
+ *                node per word.
+ *
+ *                Build : gcc -O2 -I. tests/test_packed.c $(ls *.c | grep -v main.c) -o test_packed -lpthread
+ *                Run   : ./test_packed   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "packed.h"
+
+#define TEST_FILES 5
+#define TEST_VOCABULARY 2000    // Distinct words of the generated files
+#define MAX_TEST_WORDS (TEST_VOCABULARY + 16)
+
+static int checks, failures;
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Writes file number n: words drawn from a shared vocabulary, with
+ * long shared prefixes for the front coding and words of the longest
+ * length kept by the index.
+ */
+static int write_file(char *filename, int n, int words)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    for (int i = 0; i < words; i++)
+    {
+        int r = rand() % TEST_VOCABULARY;
+        int w = (r * r) / TEST_VOCABULARY;
+        if (w % 50 == n)
+            fprintf(fp, "%c%018d ", 'a' + w % 26, w);         // MAX_WORD_LENGTH - 1 characters
+        else
+            fprintf(fp, "%cprefix%d%c", 'a' + w % 26, w, i % 12 == 11 ? '\n' : ' ');
+    }
+    fclose(fp);
+    return SUCCESS;
+}
+
+/* Sends stdout to path, or to /dev/null when path is NULL */
+static int redirect_stdout(char *path)
+{
+    fflush(stdout);
+    return freopen(path ? path : "/dev/null", "w", stdout) != NULL ? SUCCESS : FAILURE;
+}
+
+/* Returns 1 if both files hold the same bytes */
+static int same_file(char *pathA, char *pathB)
+{
+    FILE *a = fopen(pathA, "r"), *b = fopen(pathB, "r");
+    int same = a != NULL && b != NULL, ca, cb;
+    while (same && ((ca = fgetc(a)) != EOF) | ((cb = fgetc(b)) != EOF))
+        same = ca == cb;
+    if (a)
+        fclose(a);
+    if (b)
+        fclose(b);
+    return same;
+}
+
+/**
+ * Collects the words of the index and absent words around them.
+ * Returns the count.
+ */
+static int collect_words(HashTable *hashTable, char words[][MAX_WORD_LENGTH])
+{
+    const char *absent[] = {"!", "0", "aaaa", "mzzzz", "prefix", "zzzzzzzzzzzzzzzzzzz", "~"};
+    int count = 0;
+    for (size_t i = 0; i < sizeof(absent) / sizeof(absent[0]); i++)
+        snprintf(words[count++], MAX_WORD_LENGTH, "%s", absent[i]);
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        for (MainNode *node = hashTable[i].link; node && count < MAX_TEST_WORDS; node = node->mainLink)
+            snprintf(words[count++], MAX_WORD_LENGTH, "%s", node->word);
+    return count;
+}
+
+/**
+ * Searches every word in the in-memory index, in the packed file and
+ * in the index loaded from it, comparing the printed results.
+ */
+static void check_searches(HashTable *hashTable, DocTable *docs, char *path, const char *what)
+{
+    static char words[MAX_TEST_WORDS][MAX_WORD_LENGTH];
+    int count = collect_words(hashTable, words);
+    HashTable loaded[MAX_HASH_SIZE];
+    DocTable loadedDocs;
+    PackedIndex packed;
+    FileList *empty = NULL;
+    char message[100];
+
+    check(save_packed_database(hashTable, docs, path) == SUCCESS, what);
+    initialize_hashTable(loaded, MAX_HASH_SIZE);
+    initialize_docTable(&loadedDocs);
+    int status = update_database_packed(&empty, loaded, &loadedDocs, NULL, path);
+    snprintf(message, sizeof(message), "%s: load packed file", what);
+    check(status == SUCCESS, message);
+    status = packedIndex_open(&packed, path);
+    snprintf(message, sizeof(message), "%s: open packed file", what);
+    check(status == SUCCESS, message);
+    if (status == FAILURE)
+        return;
+
+    redirect_stdout("pk_memory.out");
+    for (int i = 0; i < count; i++)
+        search_word(hashTable, docs, words[i]);
+    redirect_stdout("pk_packed.out");
+    for (int i = 0; i < count; i++)
+        packedIndex_search(&packed, words[i]);
+    redirect_stdout("pk_loaded.out");
+    for (int i = 0; i < count; i++)
+        search_word(loaded, &loadedDocs, words[i]);
+    redirect_stdout(NULL);
+
+    snprintf(message, sizeof(message), "%s: packed search prints the same results (%d words)", what, count);
+    check(same_file("pk_memory.out", "pk_packed.out"), message);
+    snprintf(message, sizeof(message), "%s: loaded index prints the same results (%d words)", what, count);
+    check(same_file("pk_memory.out", "pk_loaded.out"), message);
+    packedIndex_close(&packed);
+    free_hashTable(loaded);
+    free_docTable(&loadedDocs);
+}
+
+/* Builds an index of the files named by numbers (ended by -1) */
+static int build_index(HashTable *hashTable, DocTable *docs, const int *numbers)
+{
+    FileList *filelist = NULL;
+    char filename[MAX_FILENAME_LENGTH];
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(docs);
+    for (int i = 0; numbers[i] >= 0; i++)
+    {
+        snprintf(filename, sizeof(filename), "pk%d.txt", numbers[i]);
+        fileList_insert_last(&filelist, filename);
+    }
+    int status = create_database(filelist, hashTable, docs, NULL);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+    return status;
+}
+
+/* Returns 1 if every node of the index is the one its word is found at */
+static int one_node_per_word(HashTable *hashTable)
+{
+    for (int i = 0; i < MAX_HASH_SIZE; i++)
+        for (MainNode *node = hashTable[i].link; node; node = node->mainLink)
+            if (termTable_find(&hashTable[i].terms, node->word) != node)
+                return 0;
+    return 1;
+}
+
+/**
+ * Loads a packed file of files 4, 2 and 3 into an index of files 0 to
+ * 2: the shared file keeps its counts, the packed ids map out of order,
+ * and the result must search like an index of files 0, 1, 2, 4, 3.
+ */
+static void check_merged_load(void)
+{
+    static char words[MAX_TEST_WORDS][MAX_WORD_LENGTH];
+    const int first[] = {0, 1, 2, -1}, packedFiles[] = {4, 2, 3, -1}, all[] = {0, 1, 2, 4, 3, -1};
+    HashTable hashTable[MAX_HASH_SIZE], packed[MAX_HASH_SIZE], expected[MAX_HASH_SIZE];
+    DocTable docs, packedDocs, expectedDocs;
+    FileList *empty = NULL;
+
+    check(build_index(packed, &packedDocs, packedFiles) == SUCCESS, "merged load: build packed files");
+    check(save_packed_database(packed, &packedDocs, "pk_part.txt") == SUCCESS, "merged load: pack");
+    check(build_index(hashTable, &docs, first) == SUCCESS, "merged load: build first files");
+    check(update_database_packed(&empty, hashTable, &docs, NULL, "pk_part.txt") == SUCCESS, "merged load: load packed file");
+    check(build_index(expected, &expectedDocs, all) == SUCCESS, "merged load: build every file");
+    check(one_node_per_word(hashTable), "merged load: one node per word");
+
+    int count = collect_words(expected, words);
+    redirect_stdout("pk_expected.out");
+    for (int i = 0; i < count; i++)
+        search_word(expected, &expectedDocs, words[i]);
+    redirect_stdout("pk_merged.out");
+    for (int i = 0; i < count; i++)
+        search_word(hashTable, &docs, words[i]);
+    redirect_stdout(NULL);
+    check(same_file("pk_expected.out", "pk_merged.out"), "merged load: same results as every file indexed at once");
+
+    free_hashTable(hashTable);
+    free_hashTable(packed);
+    free_hashTable(expected);
+    free_docTable(&docs);
+    free_docTable(&packedDocs);
+    free_docTable(&expectedDocs);
+}
+
+int main(void)
+{
+    FileList *filelist = NULL;
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || redirect_stdout(NULL) == FAILURE)
+        return 1;
+
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    check_searches(hashTable, &docs, "pk_empty.txt", "empty index");
+
+    srand(42);
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "pk%d.txt", n);
+        check(write_file(filename, n, 5000 + 5000 * n) == SUCCESS, "write input file");
+        fileList_insert_last(&filelist, filename);
+    }
+    check(create_database(filelist, hashTable, &docs, NULL) == SUCCESS, "create_database");
+    check_searches(hashTable, &docs, "pk_full.txt", "generated files");
+    check_merged_load();
+
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_packed: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
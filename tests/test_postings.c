@@ -0,0 +1,138 @@
+/***********************************************************************
+ *  File name   : test_postings.c
+ *  Description : Tests for the posting list kernels of the Inverted
+ *                Search Project. Every intersection and union kernel
+ *                the CPU supports, and the dispatching entry points,
+ *                must give the same ids as the scalar merge, including
+ *                empty lists, SIMD tails and skewed (galloping) sizes.
+ *
+ *                Build : gcc -O2 -I. tests/test_postings.c postings.c -o test_postings
+ *                Run   : ./test_postings
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "postings.h"
+#include "bench/sorted_lists.h"
+
+typedef int (*Kernel)(const unsigned int *, int, const unsigned int *, int, unsigned int *);
+
+typedef struct TestCase
+{
+    const char *name;
+    Kernel kernel;
+    Kernel reference;          // Scalar merge giving the expected ids
+    int minLevel;              // SIMD level required by the kernel
+} TestCase;
+
+static int checks, failures;
+
+/**
+ * Runs a kernel on a and b and compares its ids with the reference.
+ */
+static void check_case(TestCase *tc, const unsigned int *a, int na, const unsigned int *b, int nb,
+                       unsigned int *expected, unsigned int *out)
+{
+    if (postings_simd_level() < tc->minLevel)
+        return;
+    int want = tc->reference(a, na, b, nb, expected);
+    int got = tc->kernel(a, na, b, nb, out);
+    checks++;
+    if (got != want || memcmp(out, expected, want * sizeof(unsigned int)) != 0)
+    {
+        fprintf(stderr, "FAIL: %s, |A| = %d, |B| = %d: %d ids, expected %d\n", tc->name, na, nb, got, want);
+        failures++;
+    }
+}
+
+/**
+ * Compares the scalar merges themselves with a membership table.
+ */
+static void check_scalar(const unsigned int *a, int na, const unsigned int *b, int nb,
+                         unsigned int range, unsigned int *expected, unsigned int *out)
+{
+    unsigned char *member = calloc(range, 1);
+    if (member == NULL)
+        return;
+    for (int i = 0; i < na; i++)
+        member[a[i]] |= 1;
+    for (int i = 0; i < nb; i++)
+        member[b[i]] |= 2;
+
+    for (int mask = 3, pass = 0; pass < 2; pass++, mask = 0)
+    {
+        int want = 0;
+        for (unsigned int id = 0; id < range; id++)
+            if (mask ? member[id] == mask : member[id] != 0)
+                expected[want++] = id;
+        int got = pass == 0 ? postings_intersect_scalar(a, na, b, nb, out) : postings_union_scalar(a, na, b, nb, out);
+        checks++;
+        if (got != want || memcmp(out, expected, want * sizeof(unsigned int)) != 0)
+        {
+            fprintf(stderr, "FAIL: %s scalar, |A| = %d, |B| = %d: %d ids, expected %d\n",
+                    pass == 0 ? "intersect" : "union", na, nb, got, want);
+            failures++;
+        }
+    }
+    free(member);
+}
+
+int main(void)
+{
+    TestCase cases[] = {
+        {"intersect galloping", postings_intersect_galloping, postings_intersect_scalar, POSTINGS_SIMD_NONE},
+        {"intersect sse4.1", postings_intersect_sse41, postings_intersect_scalar, POSTINGS_SIMD_SSE41},
+        {"intersect avx2", postings_intersect_avx2, postings_intersect_scalar, POSTINGS_SIMD_AVX2},
+        {"intersect dispatch", postings_intersect, postings_intersect_scalar, POSTINGS_SIMD_NONE},
+        {"union sse4.1", postings_union_sse41, postings_union_scalar, POSTINGS_SIMD_SSE41},
+        {"union dispatch", postings_union, postings_union_scalar, POSTINGS_SIMD_NONE},
+    };
+    // Empty lists, lengths around the 4 and 8 id SIMD blocks, balanced and skewed lists
+    int sizes[][2] = {{0, 0}, {0, 100}, {100, 0}, {1, 1}, {3, 5}, {4, 4}, {7, 9}, {8, 8}, {9, 17},
+                      {31, 33}, {1000, 1000}, {1000, 10}, {10, 1000}, {5000, 3}, {20000, 20000}};
+    unsigned int ranges[] = {16, 256, 100000};
+
+    unsigned int *a = malloc(100000 * sizeof(unsigned int));
+    unsigned int *b = malloc(100000 * sizeof(unsigned int));
+    unsigned int *expected = malloc(200000 * sizeof(unsigned int));
+    unsigned int *out = malloc(200000 * sizeof(unsigned int));
+    if (a == NULL || b == NULL || expected == NULL || out == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not allocate test lists\n");
+        return 1;
+    }
+
+    srand(42);
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            int na = generate_list(a, sizes[s][0], ranges[r]);
+            int nb = generate_list(b, sizes[s][1], ranges[r]);
+            check_scalar(a, na, b, nb, ranges[r], expected, out);
+            for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+                check_case(&cases[k], a, na, b, nb, expected, out);
+        }
+    }
+    // Identical lists and disjoint interleaved lists
+    for (int i = 0; i < 1000; i++)
+    {
+        a[i] = 2 * i;
+        b[i] = 2 * i + 1;
+    }
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+    {
+        check_case(&cases[k], a, 1000, a, 1000, expected, out);
+        check_case(&cases[k], a, 1000, b, 1000, expected, out);
+    }
+
+    printf("test_postings: %d checks (SIMD level %d), %d failed\n", checks, postings_simd_level(), failures);
+    free(a);
+    free(b);
+    free(expected);
+    free(out);
+    return failures != 0;
+}
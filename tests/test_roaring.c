@@ -0,0 +1,269 @@
+/***********************************************************************
+ *  File name   : test_roaring.c
+ *  Description : Tests for the dense postings of the Inverted Search
+ *                Project. Roaring sets built from sorted id arrays must
+ *                give back the same ids (before and after optimizing,
+ *                copied, iterated, ANDed and ORed, the latter against
+ *                the scalar merges), and a word crossing
+ *                DENSE_POSTING_THRESHOLD must keep its files and counts.
+ *
+ *                Build : gcc -O2 -I. tests/test_roaring.c $(ls *.c | grep -v main.c) -o test_roaring -lpthread
+ *                Run   : ./test_roaring
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "postings.h"
+
+#define MAX_TEST_IDS 65536     // Largest id array of a test set
+
+static int checks, failures;
+
+static void check(int ok, const char *what, const char *set)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s (%s)\n", what, set);
+        failures++;
+    }
+}
+
+static int compare_ids(const void *x, const void *y)
+{
+    unsigned int a = *(const unsigned int *)x, b = *(const unsigned int *)y;
+    return (a > b) - (a < b);
+}
+
+/* Sorts and removes repeated ids, returns the new count */
+static int sort_unique(unsigned int *ids, int count)
+{
+    int n = 0;
+    qsort(ids, count, sizeof(unsigned int), compare_ids);
+    for (int i = 0; i < count; i++)
+        if (n == 0 || ids[n - 1] != ids[i])
+            ids[n++] = ids[i];
+    return n;
+}
+
+/**
+ * Fills ids with test set number kind (ARRAY, BITMAP and RUN shaped
+ * containers over several keys). Returns the count, or -1 past the last.
+ */
+static int generate_set(int kind, unsigned int *ids, const char **name)
+{
+    int n = 0;
+    switch (kind)
+    {
+        case 0:
+            *name = "empty";
+            break;
+        case 1:
+            *name = "container edges";
+            ids[n++] = 0;
+            ids[n++] = 65535;
+            ids[n++] = 65536;
+            ids[n++] = 131071;
+            break;
+        case 2:
+            *name = "sparse over 5 keys";
+            for (int i = 0; i < 300; i++)
+                ids[n++] = (unsigned int)rand() % 327680;
+            break;
+        case 3:
+            *name = "bitmap";
+            for (int i = 0; i < 6000; i++)
+                ids[n++] = (unsigned int)rand() % 65536;
+            break;
+        case 4:
+            *name = "runs";
+            for (unsigned int id = 1000; id < 9000; id++)
+                ids[n++] = id;
+            for (unsigned int id = 70000; id < 70010; id++)
+                ids[n++] = id;
+            for (unsigned int id = 131072; id < 196608; id += 2)
+                ids[n++] = id;
+            break;
+        case 5:
+            *name = "mixed";
+            for (int i = 0; i < 5000; i++)
+                ids[n++] = 65536 + (unsigned int)rand() % 65536;
+            for (unsigned int id = 200000; id < 210000; id++)
+                ids[n++] = id;
+            for (int i = 0; i < 100; i++)
+                ids[n++] = (unsigned int)rand() % 1000000;
+            break;
+        default:
+            return -1;
+    }
+    return sort_unique(ids, n);
+}
+
+/**
+ * Checks that set holds exactly ids[0..count).
+ */
+static void check_set(const Roaring *set, const unsigned int *ids, int count, unsigned int *out, const char *name)
+{
+    check(roaring_cardinality(set) == count, "cardinality", name);
+    check(roaring_max(set) == (count ? (int)ids[count - 1] : FAILURE), "max", name);
+    int got = roaring_to_array(set, out);
+    check(got == count && memcmp(out, ids, count * sizeof(unsigned int)) == 0, "to_array", name);
+
+    RoaringIter iter;
+    unsigned int id;
+    int n = 0, ordered = 1;
+    roaring_iter_init(&iter, set);
+    while (roaring_iterate(&iter, &id))
+        ordered &= n < count && ids[n++] == id;
+    check(ordered && n == count, "iterate", name);
+
+    int found = 1;
+    for (int i = 0; i < count; i += 1 + count / 500)
+        found &= roaring_contains(set, ids[i]) && roaring_index(set, ids[i]) == i;
+    for (int i = 0; i + 1 < count; i += 1 + count / 500)
+        if (ids[i] + 1 < ids[i + 1])
+            found &= !roaring_contains(set, ids[i] + 1) && roaring_index(set, ids[i] + 1) == FAILURE;
+    check(found, "contains / index", name);
+}
+
+/* Builds a set from ids in shuffled order, optimized if asked */
+static int build_set(Roaring *set, const unsigned int *ids, int count, unsigned int *scratch, int optimize)
+{
+    memcpy(scratch, ids, count * sizeof(unsigned int));
+    for (int i = count - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        unsigned int t = scratch[i];
+        scratch[i] = scratch[j];
+        scratch[j] = t;
+    }
+    roaring_init(set);
+    for (int i = 0; i < count; i++)
+        if (roaring_add(set, scratch[i]) == FAILURE)
+            return FAILURE;
+    if (optimize)
+        roaring_optimize(set);
+    return SUCCESS;
+}
+
+static void test_sets(void)
+{
+    static unsigned int a[MAX_TEST_IDS], b[MAX_TEST_IDS], expected[2 * MAX_TEST_IDS], out[2 * MAX_TEST_IDS];
+    const char *nameA, *nameB;
+    for (int ka = 0, na; (na = generate_set(ka, a, &nameA)) >= 0; ka++)
+    {
+        for (int optimize = 0; optimize < 2; optimize++)
+        {
+            Roaring setA, copy;
+            check(build_set(&setA, a, na, out, optimize) == SUCCESS, "add", nameA);
+            check_set(&setA, a, na, out, nameA);
+            check(roaring_copy(&copy, &setA) == SUCCESS, "copy", nameA);
+            check_set(&copy, a, na, out, nameA);
+            roaring_free(&copy);
+
+            for (int kb = 0, nb; (nb = generate_set(kb, b, &nameB)) >= 0; kb++)
+            {
+                Roaring setB, both, either, copyBoth;
+                check(build_set(&setB, b, nb, out, !optimize) == SUCCESS, "add", nameB);
+                check(roaring_and(&setA, &setB, &both) == SUCCESS, "and", nameA);
+                int count = postings_intersect_scalar(a, na, b, nb, expected);
+                check_set(&both, expected, count, out, "and");
+                check(roaring_copy(&copyBoth, &both) == SUCCESS, "copy", "and");
+                check_set(&copyBoth, expected, count, out, "copy of and");
+                roaring_free(&copyBoth);
+                check(roaring_or(&setA, &setB, &either) == SUCCESS, "or", nameA);
+                count = postings_union_scalar(a, na, b, nb, expected);
+                check_set(&either, expected, count, out, "or");
+                roaring_free(&setB);
+                roaring_free(&both);
+                roaring_free(&either);
+            }
+            roaring_free(&setA);
+        }
+    }
+}
+
+/* Compares the postings of word with the expected wordCount of every id */
+static void check_postings(HashTable *hashTable, char *word, const int *counts, int docs, const char *name)
+{
+    MainNode *node = termTable_find(&hashTable[0].terms, word);
+    int docId, wordCount, next = 0, files = 0, ok = node != NULL;
+    PostingCursor cursor;
+    if (node == NULL)
+    {
+        check(0, "word found", name);
+        return;
+    }
+    postingCursor_init(&cursor, node);
+    while (postingCursor_next(&cursor, &docId, &wordCount))
+    {
+        while (next < docs && counts[next] == 0)
+            next++;
+        ok &= next < docs && docId == next && wordCount == counts[next];
+        next++;
+    }
+    for (int id = 0; id < docs; id++)
+        files += counts[id] != 0;
+    while (next < docs && counts[next] == 0)
+        next++;
+    check(ok && next >= docs && node->fileCount == files, "postings", name);
+    check((node->docSet != NULL) == (files > DENSE_POSTING_THRESHOLD), "dense past the threshold", name);
+}
+
+/* Adds one occurrence of word in file id */
+static int add_word(HashTable *hashTable, char *word, int id, int *counts)
+{
+    char filename[MAX_FILENAME_LENGTH];
+    snprintf(filename, sizeof(filename), "f%d.txt", id);
+    counts[id]++;
+    return hashTable_insert_last(hashTable, filename, id, 0, word);
+}
+
+static void test_dense_crossing(void)
+{
+    enum { DOCS = DENSE_POSTING_THRESHOLD + 10 };
+    static HashTable hashTable[MAX_HASH_SIZE], copy[MAX_HASH_SIZE];
+    int every[DOCS] = {0}, even[DOCS] = {0}, status = SUCCESS;
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+
+    // Files are read in id order; "apple" is in every file, "avocado" in every other
+    for (int id = 0; id < DOCS; id++)
+    {
+        for (int n = 0; n <= id % 3 && status == SUCCESS; n++)
+            status = add_word(hashTable, "apple", id, every);
+        if (id % 2 == 0 && status == SUCCESS)
+            status = add_word(hashTable, "avocado", id, even);
+        if (id == DENSE_POSTING_THRESHOLD - 1 || id == DENSE_POSTING_THRESHOLD || id == DOCS - 1)
+        {
+            check_postings(hashTable, "apple", every, DOCS, "every file");
+            check_postings(hashTable, "avocado", even, DOCS, "every other file");
+        }
+    }
+    check(status == SUCCESS, "insert", "crossing");
+
+    // Words found again in earlier files
+    check(add_word(hashTable, "apple", 0, every) == SUCCESS, "insert", "earlier file");
+    check(add_word(hashTable, "apple", DOCS / 2, every) == SUCCESS, "insert", "earlier file");
+    check(add_word(hashTable, "avocado", DOCS / 2 * 2 - 2, even) == SUCCESS, "insert", "earlier file");
+    check_postings(hashTable, "apple", every, DOCS, "earlier files");
+    check_postings(hashTable, "avocado", even, DOCS, "earlier files");
+
+    check(hashTable_clone(copy, hashTable) == SUCCESS, "clone", "crossing");
+    check_postings(copy, "apple", every, DOCS, "clone");
+    check_postings(copy, "avocado", even, DOCS, "clone");
+    free_hashTable(copy);
+    free_hashTable(hashTable);
+}
+
+int main(void)
+{
+    srand(42);
+    test_sets();
+    test_dense_crossing();
+    printf("test_roaring: %d checks (DENSE_POSTING_THRESHOLD %d), %d failed\n", checks, DENSE_POSTING_THRESHOLD, failures);
+    return failures != 0;
+}
@@ -0,0 +1,185 @@
+/***********************************************************************
+ *  File name   : test_snapshot.c
+ *  Description : Tests for the index snapshots of the Inverted Search
+ *                Project. A reader that pinned a version must keep
+ *                seeing it unchanged while a writer clones, updates and
+ *                publishes the next one; the old version must then be
+ *                held by its readers only and freed by the last
+ *                release. Reader threads pinning versions while a
+ *                writer publishes must always see a whole version.
+ *
+ *                Build : gcc -O2 -I. tests/test_snapshot.c $(ls *.c | grep -v main.c) -o test_snapshot -lpthread
+ *                Run   : ./test_snapshot   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "snapshot.h"
+#include "validate.h"
+
+#define TEST_VERSIONS 8         // Versions published, each adding one file
+#define TEST_READERS 4          // Threads pinning versions while the writer publishes
+
+static int checks, failures;
+static pthread_mutex_t checkLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void check(int ok, const char *what)
+{
+    pthread_mutex_lock(&checkLock);
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+    pthread_mutex_unlock(&checkLock);
+}
+
+/**
+ * Writes file number n: the word "shared" in every file and the word
+ * "onlyn" in this one only.
+ */
+static int write_file(char *filename, int n)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    fprintf(fp, "shared only%d shared\n", n);
+    fclose(fp);
+    return SUCCESS;
+}
+
+/* Returns the number of files of word in a snapshot, 0 if absent */
+static int file_count(IndexSnapshot *snapshot, char *word)
+{
+    int index = get_word_index(word);
+    MainNode *node = termTable_find(&snapshot->hashTable[index].terms, word);
+    return node ? node->fileCount : 0;
+}
+
+/**
+ * Checks that a snapshot holds exactly the files of its version:
+ * version v indexes files 1 to v.
+ */
+static int whole_version(IndexSnapshot *snapshot)
+{
+    char word[MAX_WORD_LENGTH];
+    int v = snapshot->version;
+    int ok = snapshot->docs.count == v && file_count(snapshot, "shared") == v;
+    snprintf(word, sizeof(word), "only%d", v);
+    ok = ok && (v == 0 || file_count(snapshot, word) == 1);
+    snprintf(word, sizeof(word), "only%d", v + 1);
+    return ok && file_count(snapshot, word) == 0;
+}
+
+/**
+ * Clones the current version, indexes file number n into the copy and
+ * publishes it. Returns SUCCESS or FAILURE.
+ */
+static int publish_file(SnapshotStore *store, int n)
+{
+    char filename[MAX_FILENAME_LENGTH];
+    FileList *filelist = NULL;
+    snprintf(filename, sizeof(filename), "snap%d.txt", n);
+    IndexSnapshot *snapshot = snapshot_clone(store);
+    if (snapshot == NULL || fileList_insert_last(&filelist, filename) == FAILURE)
+        return FAILURE;
+    int status = create_database(filelist, snapshot->hashTable, &snapshot->docs, &snapshot->sketch);
+    free(filelist);
+    if (status == FAILURE)
+    {
+        snapshot_release(snapshot);
+        return FAILURE;
+    }
+    snapshot_publish(store, snapshot);
+    return SUCCESS;
+}
+
+/* ReaderState: shared by the reader threads and the writer */
+typedef struct ReaderState
+{
+    SnapshotStore *store;
+    atomic_int done;           // Set by the writer after the last publish
+} ReaderState;
+
+static void *reader_thread(void *arg)
+{
+    ReaderState *state = arg;
+    int last = 0, ok = 1, finished;
+    do
+    {
+        // One more pin after the last publish
+        finished = atomic_load(&state->done);
+        IndexSnapshot *snapshot = snapshot_acquire(state->store);
+        // Versions only move forward, and each one is complete
+        ok = ok && snapshot->version >= last && whole_version(snapshot);
+        last = snapshot->version;
+        snapshot_release(snapshot);
+    } while (!finished);
+    check(ok, "concurrent readers see whole versions in order");
+    return NULL;
+}
+
+int main(void)
+{
+    SnapshotStore store;
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    for (int n = 1; n <= TEST_VERSIONS; n++)
+    {
+        snprintf(filename, sizeof(filename), "snap%d.txt", n);
+        check(write_file(filename, n) == SUCCESS, "write input file");
+    }
+
+    // A pinned version is unchanged by the publish of the next one
+    check(snapshotStore_init(&store) == SUCCESS, "init store");
+    check(publish_file(&store, 1) == SUCCESS, "publish version 1");
+    IndexSnapshot *old = snapshot_acquire(&store);
+    check(old->version == 1 && atomic_load(&old->refCount) == 2, "version 1 held by the store and a reader");
+    check(publish_file(&store, 2) == SUCCESS, "publish version 2");
+    IndexSnapshot *current = snapshot_acquire(&store);
+    check(current != old && current->version == 2 && whole_version(current), "version 2 is current");
+    check(old->version == 1 && whole_version(old), "reader keeps version 1");
+    check(atomic_load(&old->refCount) == 1, "store released version 1");
+    check(atomic_load(&current->refCount) == 2, "version 2 held by the store and a reader");
+    // The last release frees version 1 (left to the sanitizers to watch)
+    snapshot_release(old);
+    snapshot_release(current);
+    check(atomic_load(&store.current->refCount) == 1, "reader released version 2");
+    snapshot_release(store.current);
+    pthread_mutex_destroy(&store.lock);
+
+    // Readers pin versions while a writer publishes the next ones
+    ReaderState state;
+    pthread_t readers[TEST_READERS];
+    check(snapshotStore_init(&store) == SUCCESS, "init store for concurrent readers");
+    state.store = &store;
+    atomic_init(&state.done, 0);
+    for (int t = 0; t < TEST_READERS; t++)
+        pthread_create(&readers[t], NULL, reader_thread, &state);
+    int published = 1;
+    for (int n = 1; n <= TEST_VERSIONS; n++)
+        published = published && publish_file(&store, n) == SUCCESS;
+    atomic_store(&state.done, 1);
+    check(published, "writer publishes every version");
+    for (int t = 0; t < TEST_READERS; t++)
+        pthread_join(readers[t], NULL);
+    snapshot_release(store.current);
+    pthread_mutex_destroy(&store.lock);
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_snapshot: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}
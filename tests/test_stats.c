@@ -0,0 +1,192 @@
+/***********************************************************************
+ *  File name   : test_stats.c
+ *  Description : Tests for the term statistics of the Inverted Search
+ *                Project, against word counts kept while writing a
+ *                small skewed corpus. index_top_terms() must return the
+ *                exact top words. The Space-Saving sketch fed while
+ *                indexing must bound every true count by [count -
+ *                error, count], hold every word above total / capacity
+ *                and rank the heavy hitters like the exact counts; with
+ *                room for every word it must be exact.
+ *
+ *                Build : gcc -O2 -I. tests/test_stats.c $(ls *.c | grep -v main.c) -o test_stats -lpthread
+ *                Run   : ./test_stats   (writes its files in the current directory)
+ *
+ ***********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "stats.h"
+
+#define TEST_FILES 4
+#define TEST_VOCABULARY 400     // Distinct words of the corpus
+#define TEST_CAPACITY 64        // Counters of the small sketch
+#define TEST_TOP 10             // Exact top words compared
+#define TEST_HEAVY 5            // Heavy hitters the small sketch must rank
+
+static int checks, failures;
+static long long exact[TEST_VOCABULARY];     // True count of word n
+
+static void check(int ok, const char *what)
+{
+    checks++;
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/* Writes a file of skewed words "tn", each counted in exact */
+static int write_file(char *filename, int words)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return FAILURE;
+    for (int i = 0; i < words; i++)
+    {
+        long r = rand() % TEST_VOCABULARY;
+        int w = (int)(r * r / TEST_VOCABULARY * r / TEST_VOCABULARY);   // Small numbers are frequent
+        exact[w]++;
+        fprintf(fp, "t%d%c", w, i % 12 == 11 ? '\n' : ' ');
+    }
+    fclose(fp);
+    return SUCCESS;
+}
+
+/* True count of a word of the corpus, 0 if absent */
+static long long true_count(const char *word)
+{
+    int w;
+    char extra;
+    if (sscanf(word, "t%d%c", &w, &extra) != 1 || w < 0 || w >= TEST_VOCABULARY)
+        return 0;
+    return exact[w];
+}
+
+/* Orders the exact counts like the statistics: count down, then word */
+static int compare_exact(const void *a, const void *b)
+{
+    const TermCount *x = a, *y = b;
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;
+    return strcmp(x->word, y->word);
+}
+
+/* Returns 1 if the first n entries of a and b name the same words */
+static int same_words(TermCount *a, TermCount *b, int n)
+{
+    for (int i = 0; i < n; i++)
+        if (strcmp(a[i].word, b[i].word) != 0)
+            return 0;
+    return 1;
+}
+
+int main(void)
+{
+    FileList *filelist = NULL;
+    HashTable hashTable[MAX_HASH_SIZE];
+    DocTable docs;
+    TermSketch small, full, copy;
+    static TermCount ranked[TEST_VOCABULARY], top[TEST_VOCABULARY], sketched[TEST_VOCABULARY];
+    char filename[MAX_FILENAME_LENGTH];
+
+    // The index reports progress on stdout, keep it for the summary only
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    if (console == -1 || freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    srand(42);
+    long long tokens = 0;
+    for (int n = 0; n < TEST_FILES; n++)
+    {
+        snprintf(filename, sizeof(filename), "st%d.txt", n);
+        check(write_file(filename, 2000 + 1000 * n) == SUCCESS, "write input file");
+        tokens += 2000 + 1000 * n;
+        fileList_insert_last(&filelist, filename);
+    }
+    int distinct = 0;
+    for (int w = 0; w < TEST_VOCABULARY; w++)
+        if (exact[w] > 0)
+        {
+            snprintf(ranked[distinct].word, MAX_WORD_LENGTH, "t%d", w);
+            ranked[distinct++].count = exact[w];
+        }
+    qsort(ranked, distinct, sizeof(TermCount), compare_exact);
+
+    // The same files feed a small sketch and one with room for every word
+    initialize_hashTable(hashTable, MAX_HASH_SIZE);
+    initialize_docTable(&docs);
+    termSketch_init(&small, TEST_CAPACITY);
+    termSketch_init(&full, TEST_VOCABULARY);
+    check(create_database(filelist, hashTable, &docs, &small) == SUCCESS, "create_database");
+    int fed = 1;
+    for (int i = 0; i < distinct; i++)
+        fed &= termSketch_add(&full, ranked[i].word, ranked[i].count) == SUCCESS;
+    check(fed, "feed the full sketch");
+
+    // Exact top words from the index
+    check(index_top_terms(hashTable, TEST_TOP, top) == TEST_TOP, "index_top_terms count");
+    int same = 1;
+    for (int i = 0; i < TEST_TOP; i++)
+        same &= strcmp(top[i].word, ranked[i].word) == 0 && top[i].count == ranked[i].count;
+    check(same, "index_top_terms gives the exact top words");
+
+    // Space-Saving bounds of the small sketch
+    check(small.total == tokens, "sketch total counts every token");
+    int stored = termSketch_top(&small, sketched, TEST_VOCABULARY);
+    check(stored == TEST_CAPACITY, "small sketch is full");
+    int bounded = 1, evicted = 0;
+    for (int i = 0; i < stored; i++)
+    {
+        long long truth = true_count(sketched[i].word);
+        bounded &= sketched[i].count - sketched[i].error <= truth && truth <= sketched[i].count;
+        evicted |= sketched[i].error > 0;
+    }
+    check(evicted, "small sketch evicted counters");
+    check(bounded, "true counts lie in [count - error, count]");
+    int kept = 1;
+    for (int i = 0; i < distinct && ranked[i].count > tokens / TEST_CAPACITY; i++)
+    {
+        int found = 0;
+        for (int j = 0; j < stored; j++)
+            found |= strcmp(sketched[j].word, ranked[i].word) == 0;
+        kept &= found;
+    }
+    check(kept, "every word above total / capacity is kept");
+    check(same_words(sketched, ranked, TEST_HEAVY), "heavy hitters ranked like the exact counts");
+
+    // A clone ranks the same way
+    check(termSketch_clone(&copy, &small) == SUCCESS, "clone sketch");
+    check(termSketch_top(&copy, top, TEST_VOCABULARY) == stored && same_words(top, sketched, stored), "clone keeps the counters");
+
+    // With room for every word the sketch is exact
+    stored = termSketch_top(&full, sketched, TEST_VOCABULARY);
+    int exactCounts = stored == distinct;
+    for (int i = 0; exactCounts && i < stored; i++)
+        exactCounts = sketched[i].error == 0 && sketched[i].count == ranked[i].count &&
+                      strcmp(sketched[i].word, ranked[i].word) == 0;
+    check(exactCounts, "sketch with room for every word is exact");
+
+    termSketch_free(&small);
+    termSketch_free(&full);
+    termSketch_free(&copy);
+    free_hashTable(hashTable);
+    free_docTable(&docs);
+    while (filelist)
+    {
+        FileList *next = filelist->link;
+        free(filelist);
+        filelist = next;
+    }
+
+    fflush(stdout);
+    dup2(console, STDOUT_FILENO);
+    printf("test_stats: %d checks, %d failed\n", checks, failures);
+    return failures != 0;
+}